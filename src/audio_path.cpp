@@ -0,0 +1,115 @@
+#include "audio_path.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "hal.h"
+#include "latency_trace.h"
+
+void AudioPath::begin(uint8_t volume, LatencyTrace* trace) {
+  volume_ = volume;
+  trace_ = trace;
+  state_ = hal::Speaker.isRunning() ? State::SpeakerActive : (hal::Mic.isRunning() ? State::MicActive : State::Idle);
+}
+
+bool AudioPath::requestSpeaker() {
+  switch (state_) {
+    case State::SpeakerActive:
+      ++skipped_;
+      return true;
+    case State::Transitioning:
+      // Still draining and not yet ended: the speaker is intact, keep it.
+      ++reverted_;
+      state_ = State::SpeakerActive;
+      return true;
+    case State::Idle:
+    case State::MicActive:
+      break;
+  }
+  if (!hal::Speaker.isEnabled()) {
+    return false;
+  }
+  const uint32_t t0 = hal::micros();
+  if (hal::Mic.isRunning()) {
+    hal::Mic.end();
+    if (trace_ != nullptr) {
+      trace_->mark(LatencyTrace::Stage::MicOff, hal::micros());
+    }
+  }
+  (void)hal::Speaker.begin();
+  hal::Speaker.setVolume(volume_);
+  if (trace_ != nullptr) {
+    trace_->mark(LatencyTrace::Stage::SpeakerOn, hal::micros());
+  }
+  state_ = State::SpeakerActive;
+  finish(Transition::ToSpeaker, t0);
+  return true;
+}
+
+bool AudioPath::requestMic() {
+  switch (state_) {
+    case State::MicActive:
+      ++skipped_;
+      return true;
+    case State::Transitioning:
+      poll();
+      return state_ == State::MicActive;
+    case State::Idle:
+      state_ = State::MicActive;
+      finish(Transition::ToMic, hal::micros());
+      return true;
+    case State::SpeakerActive:
+      break;
+  }
+  // Cut whatever is queued, then let poll() end the speaker once its task has drained.
+  drainStartUs_ = hal::micros();
+  hal::Speaker.stop();
+  state_ = State::Transitioning;
+  poll();
+  return state_ == State::MicActive;
+}
+
+void AudioPath::poll() {
+  if (state_ != State::Transitioning) {
+    return;
+  }
+  if (hal::Speaker.isPlaying()) {
+    if (hal::micros() - drainStartUs_ < kDrainTimeoutUs) {
+      return;
+    }
+    ++timeouts_;
+  }
+  hal::Speaker.end();
+  if (trace_ != nullptr) {
+    trace_->mark(LatencyTrace::Stage::SpeakerOff, hal::micros());
+  }
+  state_ = State::MicActive;
+  finish(Transition::ToMic, drainStartUs_);
+}
+
+void AudioPath::finish(Transition t, uint32_t startUs) {
+  const uint32_t us = hal::micros() - startUs;
+  Stats& s = stats_[(size_t)t];
+  ++s.count;
+  s.maxUs = std::max(s.maxUs, us);
+  s.sumUs += us;
+  s.lastUs = us;
+}
+
+size_t AudioPath::format(char* out, size_t len) const {
+  if (out == nullptr || len == 0) {
+    return 0;
+  }
+  out[0] = '\0';
+  static const char* const kNames[(size_t)Transition::Count] = {"to-spk", "to-mic"};
+  int n = 0;
+  for (size_t t = 0; t < (size_t)Transition::Count && n >= 0 && (size_t)n < len; ++t) {
+    const Stats& s = stats_[t];
+    const float avgMs = (s.count > 0) ? (float)s.sumUs / (1000.0f * (float)s.count) : 0.0f;
+    n += snprintf(out + n, len - (size_t)n, "%s%s n=%lu avg %.1f max %.1f last %.1f ms", (t == 0) ? "" : "  ", kNames[t], (unsigned long)s.count, avgMs, (float)s.maxUs / 1000.0f, (float)s.lastUs / 1000.0f);
+  }
+  if (n >= 0 && (size_t)n < len) {
+    n += snprintf(out + n, len - (size_t)n, "  skipped %lu reverted %lu timeouts %lu", (unsigned long)skipped_, (unsigned long)reverted_, (unsigned long)timeouts_);
+  }
+  return (n > 0) ? std::min((size_t)n, len - 1) : 0;
+}
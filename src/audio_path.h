@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class LatencyTrace;
+
+// Owner of the shared ES8311 codec. The speaker (DAC) and the mic (ADC) cannot run at the same
+// time: enabling the mic reconfigures the codec and silences output until the speaker is
+// re-initialized. Every switch goes through here, in the only order that keeps audio working:
+//   -> mic:     Speaker.stop, drain (polled, up to kDrainTimeoutUs), Speaker.end; the mic then
+//               starts on the first Mic.record
+//   -> speaker: Mic.end (if it ran), Speaker.begin, volume
+// Requests for the current configuration are no-ops, and a mic request withdrawn while the
+// speaker is still draining just keeps the speaker (no end/begin cycle). Nothing blocks except
+// the driver calls themselves; poll() finishes a pending drain from loop().
+class AudioPath {
+ public:
+  enum class State : uint8_t {
+    Idle = 0,      // neither side configured (boot)
+    SpeakerActive,
+    MicActive,     // speaker released; the mic owns the codec
+    Transitioning, // speaker draining on its way to MicActive
+  };
+
+  enum class Transition : uint8_t {
+    ToSpeaker = 0,
+    ToMic,
+    Count,
+  };
+
+  static constexpr uint32_t kDrainTimeoutUs = 200000;
+
+  // `trace` (optional) gets SpeakerOn / SpeakerOff / MicOff marks on actual transitions.
+  void begin(uint8_t volume, LatencyTrace* trace);
+
+  // Both return true once the codec is in the requested configuration. requestSpeaker()
+  // completes synchronously (false only without a speaker); requestMic() may leave the path
+  // Transitioning until poll() sees the speaker drained.
+  bool requestSpeaker();
+  bool requestMic();
+  void poll();
+
+  State state() const { return state_; }
+  bool speakerActive() const { return state_ == State::SpeakerActive; }
+  bool micActive() const { return state_ == State::MicActive; }
+
+  struct Stats {
+    uint32_t count = 0;
+    uint32_t maxUs = 0;
+    uint64_t sumUs = 0;
+    uint32_t lastUs = 0;
+  };
+  const Stats& stats(Transition t) const { return stats_[(size_t)t]; }
+  uint32_t skipped() const { return skipped_; }   // requests already satisfied
+  uint32_t reverted() const { return reverted_; } // mic requests withdrawn mid-drain
+  uint32_t timeouts() const { return timeouts_; } // drains cut short by kDrainTimeoutUs
+
+  // "to-spk n=.. avg .. max .. last .. ms  to-mic n=.. ..  skipped .. reverted .. timeouts .."
+  size_t format(char* out, size_t len) const;
+
+ private:
+  void finish(Transition t, uint32_t startUs);
+
+  LatencyTrace* trace_ = nullptr;
+  uint8_t volume_ = 0;
+  State state_ = State::Idle;
+  uint32_t drainStartUs_ = 0;
+  Stats stats_[(size_t)Transition::Count];
+  uint32_t skipped_ = 0;
+  uint32_t reverted_ = 0;
+  uint32_t timeouts_ = 0;
+};
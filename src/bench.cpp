@@ -0,0 +1,863 @@
+#include "bench.h"
+
+#if AXES_ECHO_BENCH
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "clip_library.h"
+#include "codec.h"
+#include "conditioner.h"
+#include "denoise.h"
+#include "effects.h"
+#include "fft.h"
+#include "hal.h"
+#include "latency_trace.h"
+#include "mixer.h"
+#include "render_governor.h"
+#include "resampler.h"
+#include "vad.h"
+#include "vector_scene.h"
+
+namespace {
+
+constexpr uint32_t kBenchRateHz = 16000;
+constexpr size_t kBenchSamples = kBenchRateHz;  // 1 s of audio per run
+
+int16_t* gIn = nullptr;
+int16_t* gOut = nullptr;
+size_t gOutCap = 0;
+
+void fillSine(int16_t* dst, size_t n, float hz, uint32_t rateHz, float amp) {
+  const float w = 2.0f * PI * hz / (float)rateHz;
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = (int16_t)lroundf(amp * sinf(w * (float)i));
+  }
+}
+
+// SNR of y against the best-fit sine at `hz` (time axis in input samples via stepQ16).
+float sineFitSnrDb(const int16_t* y, size_t n, float hz, uint32_t inRateHz, uint32_t stepQ16) {
+  const size_t skip = 64;
+  if (n <= 2 * skip) {
+    return 0.0f;
+  }
+  double ss = 0, cc = 0, sc = 0, ys = 0, yc = 0;
+  const double k = 2.0 * PI * hz * ((double)stepQ16 / 65536.0) / (double)inRateHz;
+  for (size_t i = skip; i < n - skip; ++i) {
+    const double s = sin(k * (double)i);
+    const double c = cos(k * (double)i);
+    ss += s * s;
+    cc += c * c;
+    sc += s * c;
+    ys += y[i] * s;
+    yc += y[i] * c;
+  }
+  const double det = ss * cc - sc * sc;
+  const double a = (ys * cc - yc * sc) / det;
+  const double b = (yc * ss - ys * sc) / det;
+  double sig = 0, err = 0;
+  for (size_t i = skip; i < n - skip; ++i) {
+    const double m = a * sin(k * (double)i) + b * cos(k * (double)i);
+    sig += m * m;
+    err += (y[i] - m) * (y[i] - m);
+  }
+  return (float)(10.0 * log10(sig / (err > 1e-9 ? err : 1e-9)));
+}
+
+float rmsDbfs(const int16_t* y, size_t n) {
+  double sum = 0;
+  for (size_t i = 0; i < n; ++i) {
+    sum += (double)y[i] * (double)y[i];
+  }
+  const double rms = sqrt(sum / (double)(n ? n : 1)) / 32768.0;
+  return (rms > 0.0) ? (float)(20.0 * log10(rms)) : -99.9f;
+}
+
+size_t runResampler(PolyphaseResampler& rs, size_t inCount, uint32_t* cycles) {
+  rs.reset();
+  size_t pos = 0;
+  size_t produced = 0;
+  const uint32_t c0 = hal::cycleCount();
+  while (pos < inCount && produced < gOutCap) {
+    size_t used = 0;
+    const size_t n = std::min<size_t>(512, inCount - pos);
+    produced += rs.process(gIn + pos, n, gOut + produced, gOutCap - produced, &used);
+    pos += used;
+  }
+  *cycles = hal::cycleCount() - c0;
+  return produced;
+}
+
+void benchResampler() {
+  static PolyphaseResampler rs;
+  struct Case {
+    uint32_t inHz;
+    uint32_t outHz;
+  };
+  static constexpr Case kCases[] = {{16000, 8000}, {8000, 16000}, {16000, 24000}, {32000, 16000}};
+
+  // Budget: < 150 cycles per output sample (~1% of one 240 MHz core at 16 kHz).
+  for (const Case& c : kCases) {
+    (void)rs.configureRates(c.inHz, c.outHz);
+    fillSine(gIn, kBenchSamples, 1000.0f, c.inHz, 16000.0f);
+    uint32_t cycles = 0;
+    const size_t n = runResampler(rs, kBenchSamples, &cycles);
+    const float cps = (float)cycles / (float)(n ? n : 1);
+    const float snr = sineFitSnrDb(gOut, n, 1000.0f, c.inHz, rs.stepQ16());
+    const bool ok = (cps < 150.0f) && (snr > 50.0f);
+    hal::logf("[bench] resample %lu->%lu: %.1f cyc/out  SNR(1k) %.1f dB  %s\n", (unsigned long)c.inHz, (unsigned long)c.outHz, cps, snr, ok ? "PASS" : "FAIL");
+  }
+
+  // Aliasing: a 6 kHz tone must not fold into the 0..4 kHz band when going 16k -> 8k.
+  (void)rs.configureRates(16000, 8000);
+  fillSine(gIn, kBenchSamples, 6000.0f, 16000, 16000.0f);
+  uint32_t cycles = 0;
+  const size_t n = runResampler(rs, kBenchSamples, &cycles);
+  const float inDb = rmsDbfs(gIn, kBenchSamples);
+  const float outDb = rmsDbfs(gOut + 64, n > 64 ? n - 64 : 0);
+  const float rejection = inDb - outDb;
+  hal::logf("[bench] resample alias 6k@16k->8k: rejection %.1f dB  %s\n", rejection, (rejection > 60.0f) ? "PASS" : "FAIL");
+}
+
+void benchTimeStretch() {
+  static TimeStretcher ts;
+  fillSine(gIn, kBenchSamples, 440.0f, kBenchRateHz, 12000.0f);
+  static constexpr uint16_t kSpeeds[] = {128, 384, 512};
+  for (uint16_t speed : kSpeeds) {
+    ts.start(gIn, kBenchSamples, speed);
+    size_t produced = 0;
+    const uint32_t c0 = hal::cycleCount();
+    while (!ts.done() && produced < gOutCap) {
+      produced += ts.render(gOut + produced, std::min<size_t>(512, gOutCap - produced));
+    }
+    const uint32_t cycles = hal::cycleCount() - c0;
+    const float cps = (float)cycles / (float)(produced ? produced : 1);
+    const size_t expect = (kBenchSamples * 256u) / speed;
+    const bool ok = (cps < 100.0f) && (produced + TimeStretcher::kHopSamples >= expect) && (produced <= expect + TimeStretcher::kHopSamples);
+    hal::logf("[bench] stretch %.2fx: %.1f cyc/out  len %u (exp %u)  %s\n", (float)speed / 256.0f, cps, (unsigned)produced, (unsigned)expect, ok ? "PASS" : "FAIL");
+  }
+}
+
+void benchVad() {
+  // Decision cost per 512-sample chunk, on a synthetic silence/speech/silence pattern.
+  static VoiceActivityDetector vad;
+  static constexpr int kFrames = 2000;
+  uint8_t bands[16];
+  vad.reset();
+  uint32_t speechFrames = 0;
+  uint32_t worst = 0;
+  uint32_t total = 0;
+  for (int f = 0; f < kFrames; ++f) {
+    const bool talk = (f % 100) >= 40 && (f % 100) < 70;
+    const float rms = talk ? -24.0f - (float)(f % 7) : -56.0f + (float)(f % 3);
+    for (size_t b = 0; b < 16; ++b) {
+      bands[b] = (uint8_t)(talk ? 55 + (b * 3) % 20 : 12 + (b % 4));
+    }
+    const uint32_t c0 = hal::cycleCount();
+    speechFrames += vad.update(rms, bands, 16) ? 1u : 0u;
+    const uint32_t dt = hal::cycleCount() - c0;
+    total += dt;
+    worst = std::max(worst, dt);
+  }
+  // 30 talk frames per 100, plus hangover after each burst.
+  const uint32_t expect = (uint32_t)(kFrames / 100) * (30 + VoiceActivityDetector::kHangoverFrames);
+  const bool detectOk = speechFrames + 20 >= expect && speechFrames <= expect + 20;
+  const bool costOk = worst < 2000;
+  hal::logf("[bench] vad decision: avg %.0f cyc  worst %lu cyc  speech %lu/%d (exp ~%lu)  %s\n", (float)total / kFrames, (unsigned long)worst, (unsigned long)speechFrames, kFrames, (unsigned long)expect, (detectOk && costOk) ? "PASS" : "FAIL");
+
+  // Trimmer: 1 s leading silence, 1 s speech, 1 s silence, 1 s speech, 1 s silence at 16 kHz.
+  static SilenceTrimmer trim;
+  static constexpr size_t kChunk = 512;
+  trim.configure(kBenchRateHz, kChunk);
+  const size_t chunksPerSec = kBenchRateHz / kChunk;
+  size_t w = 0;
+  uint32_t worstCommit = 0;
+  for (size_t c = 0; c < chunksPerSec * 5 && w + kChunk <= gOutCap; ++c) {
+    const size_t sec = c / chunksPerSec;
+    const bool talk = (sec == 1 || sec == 3);
+    bool rewritten = false;
+    const uint32_t c0 = hal::cycleCount();
+    w = trim.commit(gOut, w, kChunk, talk, &rewritten);
+    worstCommit = std::max(worstCommit, hal::cycleCount() - c0);
+  }
+  bool rewritten = false;
+  w = trim.finish(gOut, w, &rewritten);
+  const float keptSec = (float)w / (float)kBenchRateHz;
+  const float expectSec = (SilenceTrimmer::kPreRollMs + 1000 + SilenceTrimmer::kMaxGapMs + 1000 + SilenceTrimmer::kTailMs) / 1000.0f;
+  const bool trimOk = fabsf(keptSec - expectSec) < 0.1f;
+  hal::logf("[bench] trim 5.0s -> %.2fs (exp ~%.2fs)  worst commit %lu cyc  %s\n", keptSec, expectSec, (unsigned long)worstCommit, trimOk ? "PASS" : "FAIL");
+}
+
+void benchConditioner() {
+  // 3 s at 16 kHz: 1.5 s quiet (-40 dBFS) then 1.5 s hot (clipping without the limiter),
+  // both riding on a +2000 DC offset. Processed in 512-sample chunks like the capture loop.
+  static CaptureConditioner cond;
+  static constexpr size_t kChunk = 512;
+  const size_t n = std::min<size_t>(gOutCap, kBenchRateHz * 3) / (2 * kChunk) * (2 * kChunk);
+  const float w = 2.0f * PI * 300.0f / (float)kBenchRateHz;
+  for (size_t i = 0; i < n; ++i) {
+    const float amp = (i < n / 2) ? 330.0f : 30000.0f;
+    const float v = 2000.0f + amp * sinf(w * (float)i);
+    gOut[i] = (int16_t)std::max(-32768.0f, std::min(32767.0f, v));
+  }
+
+  cond.configure(kBenchRateHz);
+  uint32_t cycles = 0;
+  float quietRms = -99.9f;
+  for (size_t p = 0; p < n; p += kChunk) {
+    const uint32_t c0 = hal::cycleCount();
+    cond.process(gOut + p, kChunk);
+    cycles += hal::cycleCount() - c0;
+
+    int peak = 0;
+    for (size_t i = p; i < p + kChunk; ++i) {
+      peak = std::max(peak, (int)abs(gOut[i]));
+    }
+    const float rms = rmsDbfs(gOut + p, kChunk);
+    cond.updateAgc(rms, 20.0f * log10f(std::max(1, peak) / 32768.0f), 0.0f);
+    if (p + kChunk == n / 2) {
+      quietRms = rms;
+    }
+  }
+
+  int maxHot = 0;
+  for (size_t i = n / 2; i < n; ++i) {
+    maxHot = std::max(maxHot, (int)abs(gOut[i]));
+  }
+  double dc = 0.0;
+  for (size_t i = n / 4; i < n / 2; ++i) {
+    dc += gOut[i];
+  }
+  dc /= (double)(n / 4);
+
+  const float cps = (float)cycles / (float)n;
+  const bool ok = (cps < 30.0f) && (maxHot <= CaptureConditioner::kLimitThreshold) && (fabs(dc) < 50.0) && (quietRms > -26.0f);
+  hal::logf("[bench] condition: %.1f cyc/sample  quiet -40 -> %.1f dBFS  hot peak %d (thr %ld)  dc %.1f  %s\n", cps, quietRms, maxHot, (long)CaptureConditioner::kLimitThreshold, dc, ok ? "PASS" : "FAIL");
+}
+
+// Voiced speech stand-in: 90..180 Hz glottal harmonics through two formant-ish gains,
+// 4 Hz syllable envelope, plus a noise floor and short fricative bursts.
+void fillSpeechLike(int16_t* dst, size_t n, uint32_t rateHz, bool withNoise = true) {
+  uint32_t lfsr = 0x1234567u;
+  float phase = 0.0f;
+  for (size_t i = 0; i < n; ++i) {
+    const float t = (float)i / (float)rateHz;
+    const float f0 = 135.0f + 45.0f * sinf(2.0f * PI * 0.7f * t);
+    phase += 2.0f * PI * f0 / (float)rateHz;
+    float v = 0.0f;
+    for (int h = 1; h <= 24; ++h) {
+      const float hz = f0 * (float)h;
+      const float g = 1.0f / (1.0f + fabsf(hz - 700.0f) / 150.0f) + 0.6f / (1.0f + fabsf(hz - 1800.0f) / 250.0f);
+      v += g * sinf(phase * (float)h);
+    }
+    const float env = 0.15f + 0.85f * fabsf(sinf(PI * 4.0f * t));
+    lfsr = lfsr * 1664525u + 1013904223u;
+    const float noise = withNoise ? ((float)(lfsr >> 16) / 32768.0f - 1.0f) * ((fmodf(t, 0.5f) > 0.42f) ? 2500.0f : 60.0f) : 0.0f;
+    dst[i] = (int16_t)std::max(-32768.0f, std::min(32767.0f, 3500.0f * env * v + noise));
+  }
+}
+
+float snrDb(const int16_t* ref, const int16_t* y, size_t n) {
+  double sig = 0, err = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const double d = (double)y[i] - (double)ref[i];
+    sig += (double)ref[i] * (double)ref[i];
+    err += d * d;
+  }
+  return (float)(10.0 * log10(sig / (err > 1e-9 ? err : 1e-9)));
+}
+
+void benchCodecs() {
+  // Ratio vs PCM16, encode/decode cost and SNR on 1 s of speech-like audio at 16 kHz.
+  // Budget: encode + decode within 5% of one core at the highest capture rate (32 kHz).
+  static constexpr float kMinSnrDb[] = {18.0f, 14.0f, 8.0f};  // per kCodecs entry
+  fillSpeechLike(gIn, kBenchSamples, kBenchRateHz);
+  const float budget = 0.05f * (float)hal::cpuFreqMHz() * 1e6f / 32000.0f;
+  std::vector<uint8_t> enc;
+  for (size_t c = 0; c < kCodecCount; ++c) {
+    const AudioCodec& codec = kCodecs[c];
+    const uint32_t c0 = hal::cycleCount();
+    const bool encOk = codec.encode(gIn, kBenchSamples, enc);
+    const uint32_t c1 = hal::cycleCount();
+    const bool decOk = codec.decode(enc, gOut, kBenchSamples);
+    const uint32_t c2 = hal::cycleCount();
+
+    const float encCps = (float)(c1 - c0) / (float)kBenchSamples;
+    const float decCps = (float)(c2 - c1) / (float)kBenchSamples;
+    const float ratio = (float)(kBenchSamples * sizeof(int16_t)) / (float)(enc.empty() ? 1 : enc.size());
+    const float snr = snrDb(gIn, gOut, kBenchSamples);
+    const float minSnr = (c < sizeof(kMinSnrDb) / sizeof(kMinSnrDb[0])) ? kMinSnrDb[c] : 0.0f;
+    const bool ok = encOk && decOk && enc.size() == codecEncodedBytes(codec, kBenchSamples) && (encCps + decCps) < budget && snr > minSnr;
+    hal::logf("[bench] codec %-11s: ratio %.2fx  enc %.1f  dec %.1f cyc/sample (budget %.0f)  SNR %.1f dB  %s\n", codec.name, ratio, encCps, decCps, budget, snr, ok ? "PASS" : "FAIL");
+  }
+}
+
+struct GovernorRun {
+  uint32_t wakes = 0;
+  uint32_t frames = 0;
+};
+
+// Drives the governor on a simulated clock from t0 to t1; tilt(t) supplies the accel sample.
+template <typename Tilt>
+GovernorRun runGovernor(RenderGovernor& gov, uint32_t t0, uint32_t t1, Tilt tilt) {
+  GovernorRun r;
+  uint32_t t = t0;
+  while (t < t1) {
+    if (gov.due(t)) {
+      float ax, ay, az;
+      tilt(t, &ax, &ay, &az);
+      ++r.wakes;
+      r.frames += gov.update(t, ax, ay, az, t / 1000u) ? 1u : 0u;
+    }
+    t = std::max(t + 1, gov.nextWakeMs());
+  }
+  return r;
+}
+
+void benchGovernor() {
+  // 10 s lying still (sensor noise only), then 2 s of tilting, then a button edge while idle.
+  static RenderGovernor gov;
+  uint32_t noise = 1;
+  auto still = [&](uint32_t, float* ax, float* ay, float* az) {
+    noise = noise * 1103515245u + 12345u;
+    const float n = ((float)((noise >> 16) & 0xFF) / 255.0f - 0.5f) * 0.006f;
+    *ax = 0.01f + n;
+    *ay = -0.02f - n;
+    *az = 0.99f + n;
+  };
+  auto moving = [](uint32_t t, float* ax, float* ay, float* az) {
+    const float a = 2.0f * PI * 0.5f * (float)t / 1000.0f;
+    *ax = 0.7f * sinf(a);
+    *ay = 0.2f;
+    *az = 0.7f * cosf(a);
+  };
+
+  gov.reset(0);
+  const GovernorRun idle = runGovernor(gov, 0, 10000, still);
+  const bool idleTier = gov.tier() == RenderGovernor::Tier::Idle;
+  const GovernorRun motion = runGovernor(gov, 10000, 12000, moving);
+  (void)runGovernor(gov, 12000, 15000, still);
+  gov.wake(15010);
+  const bool edgeOk = gov.due(15010) && gov.tier() == RenderGovernor::Tier::Active && runGovernor(gov, 15010, 15011, still).frames == 1;
+
+  const float idleFps = (float)idle.frames / 10.0f;
+  const float idleWakes = (float)idle.wakes / 10.0f;
+  const float motionFps = (float)motion.frames / 2.0f;
+  const bool ok = idleTier && edgeOk && idleFps < 2.0f && idleWakes < 30.0f && motionFps > 55.0f;
+  hal::logf("[bench] governor: still %.1f fps %.1f wake/s  moving %.1f fps  edge->frame %s  %s\n", idleFps, idleWakes, motionFps, edgeOk ? "0 ms" : "late", ok ? "PASS" : "FAIL");
+}
+
+const int16_t* gMixSrc = nullptr;
+size_t gMixSrcLen = 0;
+size_t gMixSrcPos = 0;
+
+// Stream voice source: loops the bench input forever.
+size_t pullBenchStream(int16_t* out, size_t cap) {
+  size_t n = 0;
+  while (n < cap) {
+    const size_t chunk = std::min(cap - n, gMixSrcLen - gMixSrcPos);
+    memcpy(out + n, gMixSrc + gMixSrcPos, chunk * sizeof(int16_t));
+    n += chunk;
+    gMixSrcPos = (gMixSrcPos + chunk) % gMixSrcLen;
+  }
+  return n;
+}
+
+void benchMixer() {
+  // Mixer kernel cost per output sample at 32 kHz in 256-sample blocks, tone purity, and the
+  // start-latency bookkeeping. Budget: 4 tones + a stream within 5% of one core.
+  static AudioMixer mx;
+  static constexpr AudioMixer::Envelope kFlat = {5, 0, 32768, 5};
+  static constexpr float kToneHz[] = {1000.0f, 659.3f, 784.0f, 1046.5f};
+  static constexpr uint32_t kRate = 32000;
+  static constexpr size_t kBlock = 256;
+  struct Config {
+    const char* name;
+    size_t tones;
+    bool stream;
+  };
+  static constexpr Config kConfigs[] = {{"1 tone", 1, false}, {"4 tones", 4, false}, {"4 tones+stream", 4, true}};
+
+  fillSpeechLike(gIn, kBenchSamples, kBenchRateHz);
+  const float budget = 0.05f * (float)hal::cpuFreqMHz() * 1e6f / (float)kRate;
+  const size_t n = std::min<size_t>(kRate, gOutCap) / kBlock * kBlock;
+  float cps[3] = {0};
+  float toneSnr = 0.0f;
+  for (size_t c = 0; c < 3; ++c) {
+    mx.stopAll();
+    mx.setSampleRate(kRate);
+    for (size_t t = 0; t < kConfigs[c].tones; ++t) {
+      (void)mx.playTone(kToneHz[t], 1100, 8192, kFlat, AudioMixer::Wave::Sine, 0);
+    }
+    if (kConfigs[c].stream) {
+      gMixSrc = gIn;
+      gMixSrcLen = kBenchSamples;
+      gMixSrcPos = 0;
+      (void)mx.playStream(pullBenchStream, 32768, 0);
+    }
+    const uint32_t c0 = hal::cycleCount();
+    for (size_t pos = 0; pos < n; pos += kBlock) {
+      (void)mx.render(gOut + pos, kBlock, 0);
+    }
+    cps[c] = (float)(hal::cycleCount() - c0) / (float)n;
+    if (c == 0) {
+      // Skip the attack ramp; the rest is a steady sine.
+      toneSnr = sineFitSnrDb(gOut + 256, n - 256, kToneHz[0], kRate, 65536);
+    }
+  }
+
+  // Trigger at 1 ms, first block on the speaker at 6 ms; second sound waits one more block.
+  mx.stopAll();
+  mx.resetLatency();
+  (void)mx.playTone(1000.0f, 20, 8192, kFlat, AudioMixer::Wave::Soft, 1000);
+  (void)mx.render(gOut, kBlock, 6000);
+  (void)mx.playTone(500.0f, 20, 8192, kFlat, AudioMixer::Wave::Soft, 7000);
+  (void)mx.render(gOut, kBlock, 6000 + (uint32_t)(kBlock * 1000000u / kRate));
+  const AudioMixer::LatencyStats& lat = mx.latency();
+  const bool latOk = lat.count == 2 && lat.maxUs == 7000 && lat.sumUs == 12000;
+  mx.stopAll();
+  mx.resetLatency();
+
+  const bool ok = cps[2] < budget && toneSnr > 60.0f && latOk;
+  hal::logf("[bench] mixer: %s %.1f  %s %.1f  %s %.1f cyc/sample (budget %.0f)  tone SNR %.1f dB  latency %s  %s\n", kConfigs[0].name, cps[0], kConfigs[1].name, cps[1], kConfigs[2].name, cps[2], budget, toneSnr,
+            latOk ? "ok" : "wrong", ok ? "PASS" : "FAIL");
+}
+
+uint8_t clipByte(uint32_t seed, size_t i) {
+  return (uint8_t)((seed * 2654435761u + (uint32_t)i * 40503u) >> 13);
+}
+
+void benchClipLibrary() {
+  // Fragmentation stress: random stores (with oldest-first eviction) and deletes of 0.5..30 KB
+  // clips in a 256 KB arena. Checks chain/free-list invariants after every op, content of a
+  // random clip every 8 ops, and that makeRoom() never fails when the pages exist.
+  static constexpr size_t kArenaBytes = 256 * 1024;
+  static constexpr size_t kOps = 3000;
+  static ClipLibrary lib;
+  void* arena = hal::allocLarge(kArenaBytes);
+  if (arena == nullptr || !lib.init(arena, kArenaBytes)) {
+    hal::logf("[bench] clips: no arena  FAIL\n");
+    free(arena);
+    return;
+  }
+  uint8_t* scratch = reinterpret_cast<uint8_t*>(gOut);
+  const size_t scratchBytes = std::min<size_t>(gOutCap * sizeof(int16_t), 30 * 1024);
+  std::vector<uint8_t> back;
+  uint32_t rng = 0x2545F491u;
+  auto next = [&]() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+  };
+
+  bool ok = true;
+  uint32_t stores = 0, removes = 0, evictions = 0, verified = 0;
+  uint32_t storeCycles = 0, worstStore = 0, worstRemove = 0;
+  double fillSum = 0.0, wasteSum = 0.0;
+  for (size_t op = 0; op < kOps && ok; ++op) {
+    if (lib.count() == 0 || (next() % 100) < 60) {
+      const size_t bytes = 512 + next() % (scratchBytes - 512);
+      const uint32_t seed = next();
+      for (size_t i = 0; i < bytes; ++i) {
+        scratch[i] = clipByte(seed, i);
+      }
+      const size_t before = lib.count();
+      ClipLibrary::ClipInfo info;
+      info.createdMs = seed;  // the bench keeps the pattern seed here
+      const uint32_t c0 = hal::cycleCount();
+      const bool room = lib.makeRoom(bytes);
+      const uint32_t id = room ? lib.store(scratch, bytes, info) : 0;
+      const uint32_t cyc = hal::cycleCount() - c0;
+      ok = room && id != 0;
+      evictions += (uint32_t)(before + 1 - lib.count());
+      storeCycles += cyc;
+      worstStore = std::max(worstStore, cyc);
+      ++stores;
+    } else {
+      const ClipLibrary::ClipInfo* victim = lib.at(next() % lib.count());
+      const uint32_t c0 = hal::cycleCount();
+      ok = lib.remove(victim->id);
+      worstRemove = std::max(worstRemove, hal::cycleCount() - c0);
+      ++removes;
+    }
+    ok = ok && lib.check();
+
+    if (ok && (op % 8) == 0 && lib.count() > 0) {
+      const ClipLibrary::ClipInfo* c = lib.at(next() % lib.count());
+      ok = lib.read(c->id, back) && back.size() == c->bytes;
+      for (size_t i = 0; ok && i < back.size(); ++i) {
+        ok = back[i] == clipByte(c->createdMs, i);
+      }
+      ++verified;
+    }
+
+    size_t used = 0;
+    for (size_t i = 0; i < lib.count(); ++i) {
+      used += lib.at(i)->bytes;
+    }
+    const size_t usedPages = lib.totalPages() - lib.freePages();
+    fillSum += (double)usedPages / (double)lib.totalPages();
+    wasteSum += usedPages ? 1.0 - (double)used / (double)(usedPages * ClipLibrary::kPageBytes) : 0.0;
+  }
+  free(arena);
+
+  const float avgStoreKcyc = stores ? (float)storeCycles / (float)stores / 1000.0f : 0.0f;
+  hal::logf("[bench] clips: %u stores %u removes %u evictions  fill %.0f%%  page waste %.1f%%  store avg %.1f kcyc worst %.1f kcyc  remove worst %.1f kcyc  %u reads verified  %s\n", (unsigned)stores,
+            (unsigned)removes, (unsigned)evictions, 100.0 * fillSum / (double)kOps, 100.0 * wasteSum / (double)kOps, avgStoreKcyc, (float)worstStore / 1000.0f, (float)worstRemove / 1000.0f, (unsigned)verified,
+            ok ? "PASS" : "FAIL");
+}
+
+void benchLatencyTrace() {
+  // Cost of mark() (it stays on in release builds) and of collect() per event, a scripted
+  // press -> stages -> output timeline, and overrun accounting when collect() falls behind.
+  static constexpr uint32_t kMarks = 4096;
+  static constexpr uint32_t kMarkBudget = 150; // cycles; ~0.6 us at 240 MHz
+  static LatencyTrace trace;
+
+  uint32_t markCycles = 0;
+  uint32_t collectCycles = 0;
+  for (uint32_t i = 0; i < kMarks; i += 32) {
+    const uint32_t c0 = hal::cycleCount();
+    for (uint32_t k = 0; k < 32; ++k) {
+      trace.mark(LatencyTrace::Stage::RenderStart, i + k);
+    }
+    const uint32_t c1 = hal::cycleCount();
+    (void)trace.collect();
+    collectCycles += hal::cycleCount() - c1;
+    markCycles += c1 - c0;
+  }
+  const float markCyc = (float)markCycles / (float)kMarks;
+  const float collectCyc = (float)collectCycles / (float)kMarks;
+
+  using Stage = LatencyTrace::Stage;
+  using Path = LatencyTrace::Path;
+  trace.mark(Stage::ButtonEdge, 1000000, Path::PlayStart);
+  trace.mark(Stage::MicOff, 1002000);
+  trace.mark(Stage::SpeakerOn, 1003500);
+  trace.mark(Stage::PlayRaw, 1004000);
+  trace.mark(Stage::FirstPlayed, 1012000);
+  trace.mark(Stage::FirstPlayed, 1050000); // a second clip without a new edge: ignored
+  (void)trace.collect();
+  const LatencyTrace::PathStats& play = trace.stats(Path::PlayStart);
+  const bool timelineOk = play.count == 1 && play.maxUs == 12000 && play.buckets[2] == 1 && play.lastStageUs[(size_t)Stage::SpeakerOn] == 3500;
+
+  const uint32_t droppedBefore = trace.dropped();
+  for (uint32_t i = 0; i < 3 * LatencyTrace::kRingSize; ++i) {
+    trace.mark(Stage::PushDone, i);
+  }
+  const size_t got = trace.collect();
+  const bool overrunOk = got == LatencyTrace::kRingSize && trace.dropped() - droppedBefore == 2 * LatencyTrace::kRingSize;
+
+  const bool ok = timelineOk && overrunOk && markCyc < (float)kMarkBudget;
+  hal::logf("[bench] trace: mark %.1f cyc (budget %lu)  collect %.1f cyc/event  timeline %s  overrun %s  %s\n", markCyc, (unsigned long)kMarkBudget, collectCyc, timelineOk ? "ok" : "wrong", overrunOk ? "ok" : "wrong",
+            ok ? "PASS" : "FAIL");
+}
+
+void benchEffects() {
+  // Cost per sample of each effect (and the full chain) on 1 s of speech-like audio in
+  // 1024-sample blocks against the budgets in effects.h, plus behaviour checks: the first
+  // echo repeat lands at the delay with the preset's mix level, +12 st moves a 500 Hz tone to
+  // 1 kHz, and the hall reverb tail decays instead of ringing.
+  static EffectsChain fx;
+  static constexpr size_t kBlock = 1024;
+  const size_t bytes = EffectsChain::bytesFor(EffectsChain::kMaxRateHz);
+  void* storage = hal::allocLarge(bytes);
+  if (storage == nullptr || !fx.init(storage, bytes)) {
+    hal::logf("[bench] effects: no storage  FAIL\n");
+    free(storage);
+    return;
+  }
+
+  struct Config {
+    const char* name;
+    size_t echo, reverb, pitch;
+    uint32_t budget;
+  };
+  static constexpr Config kConfigs[] = {
+    {"echo", 3, 0, 0, EchoEffect::kBudgetCycles},
+    {"reverb", 0, 2, 0, ReverbEffect::kBudgetCycles},
+    {"pitch", 0, 0, 2, PitchShiftEffect::kBudgetCycles},
+    {"chain", 3, 2, 2, EffectsChain::kBudgetCycles},
+  };
+  const size_t n = kBenchSamples / kBlock * kBlock;
+  fillSpeechLike(gIn, kBenchSamples, kBenchRateHz);
+  bool costOk = true;
+  float cps[4] = {0};
+  for (size_t c = 0; c < 4; ++c) {
+    fx.select(kConfigs[c].echo, kConfigs[c].reverb, kConfigs[c].pitch);
+    fx.start(kBenchRateHz);
+    memcpy(gOut, gIn, n * sizeof(int16_t));
+    const uint32_t c0 = hal::cycleCount();
+    for (size_t pos = 0; pos < n; pos += kBlock) {
+      fx.process(gOut + pos, kBlock);
+    }
+    cps[c] = (float)(hal::cycleCount() - c0) / (float)n;
+    costOk = costOk && cps[c] < (float)kConfigs[c].budget;
+  }
+
+  // Echo impulse response: dry impulse, then the first repeat at the delay scaled by mix.
+  const EchoPreset& ep = kEchoPresets[2];
+  const size_t delay = (size_t)ep.delayMs * kBenchRateHz / 1000u;
+  fx.select(2, 0, 0);
+  fx.start(kBenchRateHz);
+  memset(gOut, 0, (3 * delay) * sizeof(int16_t));
+  gOut[0] = 16384;
+  fx.process(gOut, 3 * delay);
+  const int32_t expect = (16384 * (int32_t)ep.mixQ15) >> 15;
+  const bool echoOk = gOut[0] == 16384 && abs(gOut[delay] - expect) <= 1 && abs(gOut[2 * delay]) > 0 && abs(gOut[2 * delay]) < abs(gOut[delay]);
+
+  // Octave up: the steady part of the output should fit a 1 kHz sine far better than 500 Hz.
+  fx.select(0, 0, 2);
+  fx.start(kBenchRateHz);
+  fillSine(gOut, n, 500.0f, kBenchRateHz, 12000.0f);
+  fx.process(gOut, n);
+  const size_t skip = 2048;
+  const float fitUp = sineFitSnrDb(gOut + skip, n - skip, 1000.0f, kBenchRateHz, 65536);
+  const float fitOrig = sineFitSnrDb(gOut + skip, n - skip, 500.0f, kBenchRateHz, 65536);
+  const bool pitchOk = fitUp > 10.0f && fitOrig < 0.0f;
+
+  // Hall reverb on a short burst: the tail 1.5 s later is >30 dB down and dies out.
+  fx.select(0, 2, 0);
+  fx.start(kBenchRateHz);
+  const size_t tail = std::min<size_t>(fx.tailSamples() + kBenchRateHz / 10, gOutCap);
+  memset(gOut, 0, tail * sizeof(int16_t));
+  fillSpeechLike(gOut, kBenchRateHz / 10, kBenchRateHz);
+  fx.process(gOut, tail);
+  const size_t win = kBenchRateHz / 10;
+  const float early = rmsDbfs(gOut + win, win);
+  const float late = rmsDbfs(gOut + kBenchRateHz + win / 2, win);
+  const float end = rmsDbfs(gOut + tail - win, win);
+  const bool reverbOk = early - late > 30.0f && end < -70.0f;
+  free(storage);
+
+  const bool ok = costOk && echoOk && pitchOk && reverbOk;
+  hal::logf("[bench] effects: echo %.1f  reverb %.1f  pitch %.1f  chain %.1f cyc/sample (budget %lu/%lu/%lu/%lu)  echo %s  pitch fit 1k %.1f / 500 %.1f dB  reverb %.0f -> %.0f -> %.0f dBFS  %s\n", cps[0], cps[1], cps[2],
+            cps[3], (unsigned long)kConfigs[0].budget, (unsigned long)kConfigs[1].budget, (unsigned long)kConfigs[2].budget, (unsigned long)kConfigs[3].budget, echoOk ? "ok" : "wrong", fitUp, fitOrig, early, late, end,
+            ok ? "PASS" : "FAIL");
+}
+
+void benchDenoise() {
+  // Synthetic bench noise: one-pole low-passed white noise (a loud fan) plus 50/150 Hz hum,
+  // about -25 dBFS together. 1 s of noise alone to learn the profile, then 1 s of speech-like
+  // audio on top of it; SNR is measured on the second second against the clean speech, delayed
+  // by the suppressor latency, and the residual on the second half of the noise alone. Then a
+  // quiet-room profile (-70 dBFS hiss) followed by clean speech, which should pass nearly intact.
+  static RealFft fft;
+  static NoiseSuppressor ns;
+  static constexpr size_t kChunk = 512;
+  const size_t bytes = NoiseSuppressor::bytesFor();
+  void* storage = hal::allocLarge(bytes);
+  if (storage == nullptr || !fft.configure(NoiseSuppressor::kFrame) || !ns.init(storage, bytes, &fft)) {
+    hal::logf("[bench] denoise: no storage  FAIL\n");
+    free(storage);
+    return;
+  }
+
+  const size_t n = kBenchSamples / kChunk * kChunk;
+  const size_t lag = NoiseSuppressor::kLatencySamples;
+  fillSpeechLike(gIn, n, kBenchRateHz, false);
+  auto addNoise = [&](float fan, float hum) {
+    uint32_t lfsr = 0xACE1u;
+    float lp = 0.0f;
+    for (size_t i = 0; i < 2 * n; ++i) {
+      lfsr = lfsr * 1664525u + 1013904223u;
+      lp += 0.2f * (((float)(lfsr >> 16) / 32768.0f - 1.0f) * fan - lp);
+      const float t = (float)i / (float)kBenchRateHz;
+      const float h = hum * (sinf(2.0f * PI * 50.0f * t) + 0.4f * sinf(2.0f * PI * 150.0f * t));
+      const float v = lp + h + ((i >= n) ? (float)gIn[i - n] : 0.0f);
+      gOut[i] = (int16_t)std::max(-32768.0f, std::min(32767.0f, v));
+    }
+  };
+  auto run = [&]() {
+    ns.configure(kBenchRateHz / 2);  // rate change: drop the previous profile
+    ns.configure(kBenchRateHz);
+    ns.reset();
+    for (size_t pos = 0; pos < 2 * n; pos += kChunk) {
+      ns.process(gOut + pos, kChunk);
+    }
+  };
+
+  addNoise(8000.0f, 1400.0f);
+  const float noiseDb = rmsDbfs(gOut, n);
+  const float snrIn = snrDb(gIn, gOut + n, n);
+  const uint32_t c0 = hal::cycleCount();
+  run();
+  const float cps = (float)(hal::cycleCount() - c0) / (float)(2 * n);
+  const float snrOut = snrDb(gIn, gOut + n + lag, n - lag);
+  const float residualDb = rmsDbfs(gOut + n / 2, n / 2);
+  const float learnedDb = ns.noiseDbfs();
+
+  addNoise(80.0f, 0.0f);
+  run();
+  const float cleanSnr = snrDb(gIn, gOut + n + lag, n - lag);
+  free(storage);
+
+  const float realTime = (float)hal::cpuFreqMHz() * 1e6f / ((float)kBenchRateHz * cps);
+  const bool ok = cps < (float)NoiseSuppressor::kBudgetCycles && snrOut - snrIn > 4.0f && residualDb < noiseDb - 14.0f && cleanSnr > 15.0f;
+  hal::logf("[bench] denoise: %.1f cyc/sample (budget %lu, %.0fx real time at 16 kHz)  SNR %.1f -> %.1f dB (%+.1f)  noise %.1f -> %.1f dBFS (learned %.1f)  quiet-room speech SNR %.1f dB  %s\n", cps,
+            (unsigned long)NoiseSuppressor::kBudgetCycles, realTime, snrIn, snrOut, snrOut - snrIn, noiseDb, residualDb, learnedDb, cleanSnr, ok ? "PASS" : "FAIL");
+}
+
+void benchVectorScene() {
+  // Axes screen math and arrows. Accuracy of the integer path against the float one it
+  // replaced (atan2f, 1/sqrtf, the float basis with lroundf), per-frame math cost of both, and
+  // raster cost of the scene (3 axes + raw/filtered/gravity) with the LGFX primitives vs the
+  // anti-aliased arrows written into the buffer. Budget: the whole integer scene within 10%
+  // of a 60 fps frame (16.7 ms) on one core.
+  static constexpr int kW = 135;
+  static constexpr int kH = 240;
+  static constexpr int kFrames = 200;
+  static constexpr int32_t kOneG = 4096;
+  const float frameCycles = (float)hal::cpuFreqMHz() * 1e6f / 60.0f;
+
+  float atanErr = 0.0f;
+  for (int i = 0; i < 3600; ++i) {
+    const float t = 2.0f * PI * (float)i / 3600.0f;
+    for (float r = 40.0f; r < 70000.0f; r *= 7.0f) {
+      const int32_t x = (int32_t)lroundf(r * cosf(t));
+      const int32_t y = (int32_t)lroundf(r * sinf(t));
+      float e = fabsf((float)fastAtan2Cdeg(y, x) - atan2f((float)y, (float)x) * (18000.0f / PI));
+      atanErr = std::max(atanErr, std::min(e, 36000.0f - e));
+    }
+  }
+  float rsqrtErr = 0.0f;
+  for (uint64_t v = 1; v <= 0xFFFFFFFFull; v += 1 + v / 61) {
+    const double ref = 2147483648.0 / sqrt((double)v);
+    rsqrtErr = std::max(rsqrtErr, (float)(fabs((double)fastRsqrt((uint32_t)v) - ref) / ref * 1e6));
+  }
+
+  // Projection: subpixel fixed point vs the float basis, on random vectors up to 1.5 g.
+  static VectorScene scene;
+  scene.begin(nullptr, kW, kH, kW / 2, kH / 2 + 10, kW * 28 / 100);
+  const float axisLen = (float)(kW * 28 / 100);
+  uint32_t lcg = 7;
+  auto rnd = [&]() {
+    lcg = lcg * 1664525u + 1013904223u;
+    return (float)(lcg >> 8) / 8388608.0f - 1.0f;
+  };
+  float projErr = 0.0f;
+  for (int i = 0; i < 4096; ++i) {
+    const float x = 1.5f * rnd(), y = 1.5f * rnd(), z = 1.5f * rnd();
+    const VectorScene::Point p = scene.project((int32_t)lroundf(x * 4096.0f), (int32_t)lroundf(y * 4096.0f), (int32_t)lroundf(z * 4096.0f));
+    const float fx = (float)(kW / 2) + (x + 0.70f * z) * axisLen;
+    const float fy = (float)(kH / 2 + 10) + (-y + 0.70f * z) * axisLen;
+    const float sub = (float)(1 << VectorScene::kSubBits);
+    projErr = std::max(projErr, std::max(fabsf((float)p.x / sub - fx), fabsf((float)p.y / sub - fy)));
+  }
+
+  // Per-frame math: what drawAxesScreen computed before (norm, 3 atan2, 4 projections with
+  // lroundf, arrowhead geometry) vs the integer equivalent, for 6 vectors.
+  volatile int32_t sink = 0;
+  uint32_t c0 = hal::cycleCount();
+  for (int f = 0; f < kFrames; ++f) {
+    const float ax = 0.3f + 0.001f * (float)f, ay = -0.2f, az = 0.93f;
+    const float norm = sqrtf(ax * ax + ay * ay + az * az);
+    const float inv = 1.0f / norm;
+    int32_t acc = (int32_t)(atan2f(ay, ax) * 100.0f) + (int32_t)(atan2f(az, ax) * 100.0f) + (int32_t)(atan2f(az, ay) * 100.0f);
+    for (int v = 0; v < 6; ++v) {
+      const float dx = (ax * inv + 0.70f * az * inv) * axisLen;
+      const float dy = (-ay * inv + 0.70f * az * inv) * axisLen;
+      const int x1 = kW / 2 + (int)lroundf(dx);
+      const int y1 = kH / 2 + (int)lroundf(dy);
+      const float len = sqrtf(dx * dx + dy * dy);
+      const float ux = dx / len, uy = dy / len;
+      acc += x1 + y1 + (int)lroundf((float)x1 - ux * 10.0f - uy * 6.0f) + (int)lroundf((float)y1 - uy * 10.0f + ux * 6.0f);
+    }
+    sink = sink + acc;
+  }
+  const float floatMath = (float)(hal::cycleCount() - c0) / (float)kFrames;
+  c0 = hal::cycleCount();
+  for (int f = 0; f < kFrames; ++f) {
+    const int32_t ax = 1229 + 4 * f, ay = -819, az = 3809;
+    const uint32_t a2 = (uint32_t)(ax * ax + ay * ay + az * az);
+    const uint32_t r = fastRsqrt(a2);
+    int32_t acc = (int32_t)((a2 * (uint64_t)r) >> 31) + fastAtan2Cdeg(ay, ax) + fastAtan2Cdeg(az, ax) + fastAtan2Cdeg(az, ay);
+    for (int v = 0; v < 6; ++v) {
+      const VectorScene::Point p = scene.projectClamped(ax, ay, az, 6144);
+      const uint32_t rr = fastRsqrt((uint32_t)(p.x * p.x + p.y * p.y));
+      acc += p.x + p.y + (int32_t)((p.x * (int64_t)rr) >> 21) + (int32_t)((p.y * (int64_t)rr) >> 21);
+    }
+    sink = sink + acc;
+  }
+  const float fixedMath = (float)(hal::cycleCount() - c0) / (float)kFrames;
+
+  // Raster: the scene's six arrows through drawLine/fillTriangle vs the AA renderer.
+  lgfx::LGFX_Sprite sprite;
+  sprite.setColorDepth(16);
+  uint16_t* buf = (uint16_t*)sprite.createSprite(kW, kH);
+  float lgfxRaster = 0.0f;
+  float aaRaster = 0.0f;
+  if (buf != nullptr) {
+    scene.begin(buf, kW, kH, kW / 2, kH / 2 + 10, kW * 28 / 100);
+    const int32_t vecs[6][3] = {{kOneG, 0, 0}, {0, kOneG, 0}, {0, 0, kOneG}, {1229, -819, 3809}, {1100, -700, 3900}, {900, -600, 4000}};
+    static constexpr uint16_t kColors[6] = {TFT_RED, TFT_GREEN, TFT_BLUE, TFT_MAGENTA, TFT_CYAN, TFT_YELLOW};
+    c0 = hal::cycleCount();
+    for (int f = 0; f < kFrames / 4; ++f) {
+      for (int v = 0; v < 6; ++v) {
+        const VectorScene::Point p = scene.project(vecs[v][0], vecs[v][1], vecs[v][2]);
+        const int x0 = kW / 2, y0 = kH / 2 + 10;
+        const int x1 = p.x >> VectorScene::kSubBits, y1 = p.y >> VectorScene::kSubBits;
+        const float dx = (float)(x1 - x0), dy = (float)(y1 - y0);
+        const float len = sqrtf(dx * dx + dy * dy);
+        sprite.drawLine(x0, y0, x1, y1, kColors[v]);
+        const float ux = dx / len, uy = dy / len;
+        const float bx = (float)x1 - ux * 10.0f, by = (float)y1 - uy * 10.0f;
+        sprite.fillTriangle(x1, y1, (int)lroundf(bx - uy * 6.0f), (int)lroundf(by + ux * 6.0f), (int)lroundf(bx + uy * 6.0f), (int)lroundf(by - ux * 6.0f), kColors[v]);
+      }
+    }
+    lgfxRaster = (float)(hal::cycleCount() - c0) / (float)(kFrames / 4);
+    c0 = hal::cycleCount();
+    for (int f = 0; f < kFrames / 4; ++f) {
+      for (int v = 0; v < 6; ++v) {
+        scene.drawArrow(scene.projectClamped(vecs[v][0], vecs[v][1], vecs[v][2], 6144), kColors[v]);
+      }
+    }
+    aaRaster = (float)(hal::cycleCount() - c0) / (float)(kFrames / 4);
+    sprite.deleteSprite();
+  }
+
+  const float sceneCycles = fixedMath + aaRaster;
+  const bool accOk = atanErr <= (float)kAtan2MaxErrCdeg && rsqrtErr <= (float)kRsqrtMaxErrPpm && projErr <= 0.1f;
+  const bool ok = accOk && buf != nullptr && sceneCycles < 0.10f * frameCycles;
+  hal::logf("[bench] vectors: atan2 err %.1f cdeg (bound %ld)  rsqrt err %.0f ppm (bound %lu)  proj err %.3f px  math %.0f -> %.0f cyc/frame  raster lgfx %.0f  aa %.0f cyc/frame  scene %.2f%% of a 60 fps frame (budget 10%%)  %s\n",
+            atanErr, (long)kAtan2MaxErrCdeg, rsqrtErr, (unsigned long)kRsqrtMaxErrPpm, projErr, floatMath, fixedMath, lgfxRaster, aaRaster, 100.0f * sceneCycles / frameCycles, ok ? "PASS" : "FAIL");
+}
+
+}  // namespace
+
+void runBenchmarks() {
+  gOutCap = kBenchSamples * 3 + 1024;
+  gIn = (int16_t*)hal::allocLarge(kBenchSamples * sizeof(int16_t));
+  gOut = (int16_t*)hal::allocLarge(gOutCap * sizeof(int16_t));
+  if (gIn == nullptr || gOut == nullptr) {
+    hal::logf("[bench] ERROR: no memory for bench buffers\n");
+    free(gIn);
+    free(gOut);
+    return;
+  }
+
+  hal::logf("[bench] CPU %lu MHz\n", (unsigned long)hal::cpuFreqMHz());
+  benchResampler();
+  benchTimeStretch();
+  benchVad();
+  benchConditioner();
+  benchDenoise();
+  benchCodecs();
+  benchGovernor();
+  benchVectorScene();
+  benchMixer();
+  benchClipLibrary();
+  benchLatencyTrace();
+  benchEffects();
+
+  free(gIn);
+  free(gOut);
+  gIn = nullptr;
+  gOut = nullptr;
+}
+
+#endif
@@ -0,0 +1,14 @@
+#pragma once
+
+// On-device DSP micro-benchmarks and accuracy checks.
+//
+// Built only in the `m5stack-sticks3-bench` PlatformIO environment (AXES_ECHO_BENCH=1) and
+// run once at the end of setup(). Each check prints one `[bench]` line over Serial with
+// cycles per sample and a PASS/FAIL verdict against its documented budget.
+#ifndef AXES_ECHO_BENCH
+#define AXES_ECHO_BENCH 0
+#endif
+
+#if AXES_ECHO_BENCH
+void runBenchmarks();
+#endif
@@ -0,0 +1,69 @@
+#include "boot_profile.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+using Phase = BootProfile::Phase;
+
+constexpr uint16_t bit(Phase p) {
+  return (uint16_t)(1u << (uint8_t)p);
+}
+
+constexpr uint16_t kReadyMask = bit(Phase::RecBuffer) | bit(Phase::Landscape) | bit(Phase::Speaker);
+
+const char* const kPhaseNames[(size_t)Phase::Count] = {"hal", "first-frame", "rec-buffer", "landscape", "speaker", "clip-library", "effects"};
+
+}  // namespace
+
+void BootProfile::record(Phase phase, uint32_t startUs, uint32_t endUs) {
+  if (phase >= Phase::Count || done(phase)) {
+    return;
+  }
+  startUs_[(size_t)phase] = startUs;
+  endUs_[(size_t)phase] = endUs;
+  mask_ |= bit(phase);
+}
+
+bool BootProfile::ready() const {
+  return (mask_ & kReadyMask) == kReadyMask;
+}
+
+uint32_t BootProfile::readyUs() const {
+  if (!ready()) {
+    return 0;
+  }
+  return std::max({endUs_[(size_t)Phase::RecBuffer], endUs_[(size_t)Phase::Landscape], endUs_[(size_t)Phase::Speaker]});
+}
+
+size_t BootProfile::formatPhase(Phase phase, char* out, size_t len) const {
+  if (out == nullptr || len == 0) {
+    return 0;
+  }
+  out[0] = '\0';
+  if (phase >= Phase::Count || !done(phase)) {
+    return 0;
+  }
+  const size_t i = (size_t)phase;
+  const int n = snprintf(out, len, "%s %.1f ms (at %.1f ms)", kPhaseNames[i], (float)(endUs_[i] - startUs_[i]) / 1000.0f, (float)endUs_[i] / 1000.0f);
+  return (n > 0) ? std::min((size_t)n, len - 1) : 0;
+}
+
+size_t BootProfile::formatSummary(char* out, size_t len) const {
+  if (out == nullptr || len == 0) {
+    return 0;
+  }
+  uint32_t initUs = 0;
+  for (size_t i = 0; i < (size_t)Phase::Count; ++i) {
+    initUs = std::max(initUs, endUs_[i]);
+  }
+  char readyMs[16];
+  if (ready()) {
+    snprintf(readyMs, sizeof(readyMs), "%.1f", (float)readyUs() / 1000.0f);
+  } else {
+    snprintf(readyMs, sizeof(readyMs), "--");
+  }
+  const int n = snprintf(out, len, "first-frame %.1f ms  ready %s ms  init %.1f ms", (float)firstFrameUs() / 1000.0f, readyMs, (float)initUs / 1000.0f);
+  return (n > 0) ? std::min((size_t)n, len - 1) : 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Boot timeline in microseconds since reset (hal::micros()), one entry per initialization
+// phase, whether it runs in setup() or is deferred to the loop. Two derived numbers track what
+// a user waits for:
+//   first-frame: reset -> first axes frame pushed to the panel
+//   ready      : reset -> KEY2 starts a take without waiting on initialization
+//                (record buffer, landscape frame and speaker all up)
+class BootProfile {
+ public:
+  enum class Phase : uint8_t {
+    Hal = 0,     // M5.begin: PMIC, display, IMU, codec config
+    FirstFrame,  // portrait sprite + first IMU read + first push
+    RecBuffer,   // PCM buffer, waveform overview and denoiser scratch
+    Landscape,   // status-screen sprite
+    Speaker,     // I2S/codec speaker bring-up
+    ClipLibrary, // clip arena
+    Effects,     // effect delay lines
+    Count,
+  };
+
+  // First record of a phase wins; later ones (e.g. a lazy re-entry) are ignored.
+  void record(Phase phase, uint32_t startUs, uint32_t endUs);
+  bool done(Phase phase) const { return (mask_ & (1u << (uint8_t)phase)) != 0; }
+  bool ready() const;
+  bool complete() const { return mask_ == (1u << (uint8_t)Phase::Count) - 1u; }
+
+  uint32_t firstFrameUs() const { return endUs_[(size_t)Phase::FirstFrame]; }
+  // Latest end among the ready phases; 0 until ready().
+  uint32_t readyUs() const;
+
+  // "<phase> <duration> ms (at <end> ms)"
+  size_t formatPhase(Phase phase, char* out, size_t len) const;
+  // "first-frame <ms> ms  ready <ms> ms  init <ms> ms" (init = all phases finished)
+  size_t formatSummary(char* out, size_t len) const;
+
+ private:
+  uint32_t startUs_[(size_t)Phase::Count] = {0};
+  uint32_t endUs_[(size_t)Phase::Count] = {0};
+  uint16_t mask_ = 0;
+};
@@ -0,0 +1,188 @@
+#include "clip_library.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool ClipLibrary::init(void* storage, size_t storageBytes) {
+  arena_ = nullptr;
+  pageCount_ = 0;
+  freeHead_ = kNoPage;
+  freeCount_ = 0;
+  count_ = 0;
+  for (Slot& s : slots_) {
+    s = Slot();
+  }
+  const size_t pages = std::min(storageBytes / kPageBytes, kMaxPages);
+  if (storage == nullptr || pages == 0) {
+    return false;
+  }
+  arena_ = static_cast<uint8_t*>(storage);
+  pageCount_ = pages;
+  // Free list in address order so a fresh library fills the arena front to back.
+  for (size_t p = 0; p < pages; ++p) {
+    next_[p] = (p + 1 < pages) ? (uint16_t)(p + 1) : kNoPage;
+  }
+  freeHead_ = 0;
+  freeCount_ = pages;
+  return true;
+}
+
+const ClipLibrary::ClipInfo* ClipLibrary::at(size_t pos) const {
+  if (pos >= count_) {
+    return nullptr;
+  }
+  return &slots_[order_[count_ - 1 - pos]].info;
+}
+
+int ClipLibrary::find(uint32_t id) const {
+  for (size_t i = 0; i < count_; ++i) {
+    if (slots_[order_[i]].info.id == id) {
+      return (int)(count_ - 1 - i);
+    }
+  }
+  return -1;
+}
+
+int ClipLibrary::slotOf(uint32_t id) const {
+  if (id == 0) {
+    return -1;
+  }
+  for (size_t s = 0; s < kMaxClips; ++s) {
+    if (slots_[s].info.id == id) {
+      return (int)s;
+    }
+  }
+  return -1;
+}
+
+bool ClipLibrary::makeRoom(size_t bytes) {
+  const size_t need = pagesFor(bytes);
+  if (!isReady() || bytes == 0 || need > pageCount_) {
+    return false;
+  }
+  while (count_ > 0 && (freeCount_ < need || count_ >= kMaxClips)) {
+    (void)remove(slots_[order_[0]].info.id);
+  }
+  return freeCount_ >= need && count_ < kMaxClips;
+}
+
+uint32_t ClipLibrary::store(const uint8_t* data, size_t bytes, const ClipInfo& info) {
+  const size_t need = pagesFor(bytes);
+  if (!isReady() || data == nullptr || bytes == 0 || need > freeCount_ || count_ >= kMaxClips) {
+    return 0;
+  }
+  int slot = -1;
+  for (size_t s = 0; s < kMaxClips; ++s) {
+    if (slots_[s].info.id == 0) {
+      slot = (int)s;
+      break;
+    }
+  }
+  if (slot < 0) {
+    return 0;
+  }
+
+  // Detach `need` pages from the free list, filling each as it goes.
+  Slot& dst = slots_[slot];
+  dst.firstPage = freeHead_;
+  dst.pages = (uint16_t)need;
+  uint16_t p = freeHead_;
+  uint16_t last = kNoPage;
+  size_t off = 0;
+  for (size_t i = 0; i < need; ++i) {
+    const size_t n = std::min(kPageBytes, bytes - off);
+    memcpy(page(p), data + off, n);
+    off += n;
+    last = p;
+    p = next_[p];
+  }
+  next_[last] = kNoPage;
+  freeHead_ = p;
+  freeCount_ -= need;
+
+  dst.info = info;
+  dst.info.id = nextId_++;
+  dst.info.bytes = (uint32_t)bytes;
+  order_[count_++] = (uint8_t)slot;
+  return dst.info.id;
+}
+
+bool ClipLibrary::remove(uint32_t id) {
+  const int slot = slotOf(id);
+  if (slot < 0) {
+    return false;
+  }
+  Slot& s = slots_[slot];
+  // Splice the whole chain onto the free list: walk to its tail once, no data touched.
+  uint16_t tail = s.firstPage;
+  while (next_[tail] != kNoPage) {
+    tail = next_[tail];
+  }
+  next_[tail] = freeHead_;
+  freeHead_ = s.firstPage;
+  freeCount_ += s.pages;
+  s = Slot();
+
+  size_t i = 0;
+  while (order_[i] != (uint8_t)slot) {
+    ++i;
+  }
+  memmove(order_ + i, order_ + i + 1, count_ - i - 1);
+  --count_;
+  return true;
+}
+
+bool ClipLibrary::read(uint32_t id, std::vector<uint8_t>& out) const {
+  const int slot = slotOf(id);
+  if (slot < 0) {
+    return false;
+  }
+  const Slot& s = slots_[slot];
+  const size_t bytes = s.info.bytes;
+  out.resize(bytes);
+  uint16_t p = s.firstPage;
+  for (size_t off = 0; off < bytes; off += kPageBytes) {
+    memcpy(out.data() + off, page(p), std::min(kPageBytes, bytes - off));
+    p = next_[p];
+  }
+  return true;
+}
+
+bool ClipLibrary::check() const {
+  std::vector<uint8_t> seen(pageCount_, 0);
+  auto walk = [&](uint16_t p, size_t expect) {
+    size_t n = 0;
+    while (p != kNoPage) {
+      if (p >= pageCount_ || seen[p] || ++n > expect) {
+        return false;
+      }
+      seen[p] = 1;
+      p = next_[p];
+    }
+    return n == expect;
+  };
+
+  size_t used = 0;
+  size_t live = 0;
+  for (size_t s = 0; s < kMaxClips; ++s) {
+    const Slot& slot = slots_[s];
+    if (slot.info.id == 0) {
+      continue;
+    }
+    ++live;
+    if (slot.pages != pagesFor(slot.info.bytes) || !walk(slot.firstPage, slot.pages)) {
+      return false;
+    }
+    used += slot.pages;
+  }
+  if (live != count_ || !walk(freeHead_, freeCount_) || used + freeCount_ != pageCount_) {
+    return false;
+  }
+  // Index: each live slot once, oldest first (ids only grow).
+  for (size_t i = 0; i < count_; ++i) {
+    if (slots_[order_[i]].info.id == 0 || (i > 0 && slots_[order_[i]].info.id <= slots_[order_[i - 1]].info.id)) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Encoded clips kept in one caller-owned arena (PSRAM preferred), allocated in fixed pages.
+//
+// A clip is a chain of pages linked through a side table, so any free page can serve any
+// clip: there is no external fragmentation and nothing ever needs compacting. Freeing a clip
+// only relinks its pages onto the free list; audio bytes never move once written, so a clip
+// being read (or played) is never copied behind the reader's back. The price is at most one
+// partly used page per clip (~1 KB on average, a few % of a short IMA take).
+//
+// Metadata lives outside the arena in a fixed slot table plus an age-ordered index, so
+// listing and selecting clips cost O(1) per entry regardless of clip length. When the arena
+// or the slot table is full, makeRoom() evicts the oldest clips.
+class ClipLibrary {
+ public:
+  static constexpr size_t kPageBytes = 2048;
+  static constexpr size_t kMaxPages = 2048;  // arenas up to 4 MB
+  static constexpr size_t kMaxClips = 32;
+
+  struct ClipInfo {
+    uint32_t id = 0;         // assigned by store(), never reused; 0 = none
+    uint32_t createdMs = 0;  // uptime at capture
+    uint32_t samples = 0;    // decoded length
+    uint32_t capturedSamples = 0; // before silence trimming
+    uint32_t rateHz = 0;
+    uint32_t bytes = 0;      // encoded size
+    uint8_t codec = 0;       // CodecId
+    float rmsDbfs = -99.9f;
+    float peakDbfs = -99.9f;
+  };
+
+  // Caller owns storage. Returns false if it holds less than one page.
+  bool init(void* storage, size_t storageBytes);
+  bool isReady() const { return pageCount_ > 0; }
+
+  size_t count() const { return count_; }
+  // pos 0 is the newest clip; nullptr past the end.
+  const ClipInfo* at(size_t pos) const;
+  // Position of the clip with this id, or -1.
+  int find(uint32_t id) const;
+
+  size_t totalPages() const { return pageCount_; }
+  size_t freePages() const { return freeCount_; }
+  static size_t pagesFor(size_t bytes) { return (bytes + kPageBytes - 1) / kPageBytes; }
+
+  // Evicts oldest clips until a clip of `bytes` fits; false if it never can.
+  bool makeRoom(size_t bytes);
+
+  // Copies data into free pages; returns the new clip id, or 0 if it does not fit (no eviction).
+  uint32_t store(const uint8_t* data, size_t bytes, const ClipInfo& info);
+  bool remove(uint32_t id);
+
+  // Gathers the clip's pages into out (resized to the clip's encoded size).
+  bool read(uint32_t id, std::vector<uint8_t>& out) const;
+
+  // Consistency check for stress tests: every page is on exactly one chain or the free list
+  // and the index matches the slot table.
+  bool check() const;
+
+ private:
+  static constexpr uint16_t kNoPage = 0xFFFF;
+
+  struct Slot {
+    ClipInfo info;
+    uint16_t firstPage = kNoPage;
+    uint16_t pages = 0;
+  };
+
+  uint8_t* page(uint16_t p) const { return arena_ + (size_t)p * kPageBytes; }
+  int slotOf(uint32_t id) const;
+
+  uint8_t* arena_ = nullptr;
+  size_t pageCount_ = 0;
+  uint16_t next_[kMaxPages];
+  uint16_t freeHead_ = kNoPage;
+  size_t freeCount_ = 0;
+
+  Slot slots_[kMaxClips];
+  uint8_t order_[kMaxClips];  // slot indices, oldest first
+  size_t count_ = 0;
+  uint32_t nextId_ = 1;
+};
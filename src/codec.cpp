@@ -0,0 +1,221 @@
+#include "codec.h"
+
+namespace {
+
+struct AdpcmState {
+  int predictor = 0;
+  int index = 0;
+};
+
+constexpr int kImaStepTable[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+  34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+  157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+  724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+  3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+  15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+// Step index adjustment by code magnitude (sign bit stripped). The narrow tables grow the
+// step faster than the SWF 2/3-bit ones ({-1,-1,2,4} / {-1,2}): with so few levels a slow
+// attack costs more than overload, +4..6 dB SNR on speech.
+constexpr int8_t kIndexTable4[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+constexpr int8_t kIndexTable3[4] = {-1, 0, 3, 6};
+constexpr int8_t kIndexTable2[2] = {-2, 6};
+
+constexpr size_t kHeaderBytes = 4;
+
+template <int Bits>
+struct AdpcmTraits;
+
+template <>
+struct AdpcmTraits<4> {
+  static constexpr const int8_t* indexTable = kIndexTable4;
+  static constexpr uint8_t headerTag = 0;  // matches the original IMA stream layout
+};
+
+template <>
+struct AdpcmTraits<3> {
+  static constexpr const int8_t* indexTable = kIndexTable3;
+  static constexpr uint8_t headerTag = 3;
+};
+
+template <>
+struct AdpcmTraits<2> {
+  static constexpr const int8_t* indexTable = kIndexTable2;
+  static constexpr uint8_t headerTag = 2;
+};
+
+int clampPredictor(int p) {
+  if (p > 32767) return 32767;
+  if (p < -32768) return -32768;
+  return p;
+}
+
+int clampIndex(int i) {
+  if (i < 0) return 0;
+  if (i > 88) return 88;
+  return i;
+}
+
+// Successive approximation of |diff| against step, step/2, ...; the reconstruction adds
+// the final halved step so the decoder lands mid-interval (IMA rounding).
+template <int Bits>
+uint8_t encodeSample(int16_t sample, AdpcmState& st) {
+  constexpr uint8_t kSign = 1u << (Bits - 1);
+  int step = kImaStepTable[st.index];
+  int diff = (int)sample - st.predictor;
+  uint8_t code = 0;
+  if (diff < 0) {
+    code = kSign;
+    diff = -diff;
+  }
+
+  int delta = 0;
+  for (uint8_t k = kSign >> 1; k != 0; k >>= 1) {
+    if (diff >= step) {
+      code |= k;
+      diff -= step;
+      delta += step;
+    }
+    step >>= 1;
+  }
+  delta += step;
+
+  st.predictor = clampPredictor((code & kSign) ? st.predictor - delta : st.predictor + delta);
+  st.index = clampIndex(st.index + AdpcmTraits<Bits>::indexTable[code & (kSign - 1)]);
+  return code;
+}
+
+template <int Bits>
+int16_t decodeSample(uint8_t code, AdpcmState& st) {
+  constexpr uint8_t kSign = 1u << (Bits - 1);
+  int step = kImaStepTable[st.index];
+  int delta = 0;
+  for (uint8_t k = kSign >> 1; k != 0; k >>= 1) {
+    if (code & k) {
+      delta += step;
+    }
+    step >>= 1;
+  }
+  delta += step;
+
+  st.predictor = clampPredictor((code & kSign) ? st.predictor - delta : st.predictor + delta);
+  st.index = clampIndex(st.index + AdpcmTraits<Bits>::indexTable[code & (kSign - 1)]);
+  return (int16_t)st.predictor;
+}
+
+size_t payloadBytes(size_t samples, int bits) {
+  const size_t codes = (samples > 1) ? (samples - 1) : 0;
+  return (codes * (size_t)bits + 7) / 8;
+}
+
+template <int Bits>
+bool encodeBuffer(const int16_t* pcm, size_t samples, std::vector<uint8_t>& out) {
+  out.clear();
+  if (samples == 0 || pcm == nullptr) {
+    return false;
+  }
+
+  // Header: predictor (LE int16), index (uint8), code bits (uint8, 0 = IMA)
+  AdpcmState st;
+  st.predictor = pcm[0];
+  st.index = 0;
+  out.reserve(kHeaderBytes + payloadBytes(samples, Bits));
+  out.push_back((uint8_t)(st.predictor & 0xFF));
+  out.push_back((uint8_t)((st.predictor >> 8) & 0xFF));
+  out.push_back((uint8_t)(st.index & 0xFF));
+  out.push_back(AdpcmTraits<Bits>::headerTag);
+
+  uint32_t acc = 0;
+  int accBits = 0;
+  for (size_t i = 1; i < samples; ++i) {
+    acc |= (uint32_t)encodeSample<Bits>(pcm[i], st) << accBits;
+    accBits += Bits;
+    if (accBits >= 8) {
+      out.push_back((uint8_t)(acc & 0xFF));
+      acc >>= 8;
+      accBits -= 8;
+    }
+  }
+  if (accBits > 0) {
+    out.push_back((uint8_t)(acc & 0xFF));
+  }
+  return true;
+}
+
+template <int Bits>
+bool decodeBuffer(const std::vector<uint8_t>& in, int16_t* pcmOut, size_t samples) {
+  if (pcmOut == nullptr || samples == 0) {
+    return false;
+  }
+  if (in.size() < kHeaderBytes || in[3] != AdpcmTraits<Bits>::headerTag) {
+    return false;
+  }
+
+  AdpcmState st;
+  st.predictor = (int16_t)((int)in[0] | ((int)in[1] << 8));
+  st.index = clampIndex((int)in[2]);
+
+  pcmOut[0] = (int16_t)st.predictor;
+  size_t pcmIdx = 1;
+  uint32_t acc = 0;
+  int accBits = 0;
+  constexpr uint32_t kMask = (1u << Bits) - 1;
+  for (size_t i = kHeaderBytes; i < in.size() && pcmIdx < samples; ++i) {
+    acc |= (uint32_t)in[i] << accBits;
+    accBits += 8;
+    while (accBits >= Bits && pcmIdx < samples) {
+      pcmOut[pcmIdx++] = decodeSample<Bits>((uint8_t)(acc & kMask), st);
+      acc >>= Bits;
+      accBits -= Bits;
+    }
+  }
+  return pcmIdx == samples;
+}
+
+}  // namespace
+
+bool imaAdpcmEncodeBuffer(const int16_t* pcm, size_t samples, std::vector<uint8_t>& out) {
+  return encodeBuffer<4>(pcm, samples, out);
+}
+
+bool imaAdpcmDecodeToBuffer(const std::vector<uint8_t>& in, int16_t* pcmOut, size_t samples) {
+  return decodeBuffer<4>(in, pcmOut, samples);
+}
+
+bool adpcm3EncodeBuffer(const int16_t* pcm, size_t samples, std::vector<uint8_t>& out) {
+  return encodeBuffer<3>(pcm, samples, out);
+}
+
+bool adpcm3DecodeToBuffer(const std::vector<uint8_t>& in, int16_t* pcmOut, size_t samples) {
+  return decodeBuffer<3>(in, pcmOut, samples);
+}
+
+bool adpcm2EncodeBuffer(const int16_t* pcm, size_t samples, std::vector<uint8_t>& out) {
+  return encodeBuffer<2>(pcm, samples, out);
+}
+
+bool adpcm2DecodeToBuffer(const std::vector<uint8_t>& in, int16_t* pcmOut, size_t samples) {
+  return decodeBuffer<2>(in, pcmOut, samples);
+}
+
+const AudioCodec kCodecs[] = {
+  {CodecId::Ima4, "IMA 4-bit", 4, imaAdpcmEncodeBuffer, imaAdpcmDecodeToBuffer},
+  {CodecId::Adpcm3, "ADPCM 3-bit", 3, adpcm3EncodeBuffer, adpcm3DecodeToBuffer},
+  {CodecId::Adpcm2, "ADPCM 2-bit", 2, adpcm2EncodeBuffer, adpcm2DecodeToBuffer},
+};
+const size_t kCodecCount = sizeof(kCodecs) / sizeof(kCodecs[0]);
+
+const AudioCodec& codecFor(CodecId id) {
+  for (size_t i = 0; i < kCodecCount; ++i) {
+    if (kCodecs[i].id == id) {
+      return kCodecs[i];
+    }
+  }
+  return kCodecs[0];
+}
+
+size_t codecEncodedBytes(const AudioCodec& codec, size_t samples) {
+  return (samples == 0) ? 0 : kHeaderBytes + payloadBytes(samples, codec.bitsPerSample);
+}
@@ -0,0 +1,123 @@
+#include "conditioner.h"
+
+#include <cmath>
+
+namespace {
+
+constexpr float kPi = 3.14159265358979f;
+
+int16_t sat16(int32_t v) {
+  if (v > 32767) return 32767;
+  if (v < -32768) return -32768;
+  return (int16_t)v;
+}
+
+int32_t dbToQ12(float db) {
+  return (int32_t)lroundf(4096.0f * powf(10.0f, db / 20.0f));
+}
+
+}  // namespace
+
+void CaptureConditioner::configure(uint32_t rateHz) {
+  if (rateHz == 0) {
+    rateHz = 16000;
+  }
+  const float a = 1.0f - (2.0f * kPi * (float)kDcCornerHz) / (float)rateHz;
+  dcCoeffQ15_ = (int32_t)lroundf(a * 32768.0f);
+  reset();
+}
+
+void CaptureConditioner::reset() {
+  x1_ = 0;
+  y1Q8_ = 0;
+  agcDb_ = 0.0f;
+  agcGainQ12_ = 4096;
+  gainQ12_ = 4096;
+}
+
+float CaptureConditioner::lastGainDb() const {
+  return 20.0f * log10f((float)gainQ12_ / 4096.0f);
+}
+
+void CaptureConditioner::process(int16_t* pcm, size_t n) {
+  if (pcm == nullptr || n == 0) {
+    return;
+  }
+
+  // Pass 1: DC blocker in place; track the peak and the first sample that would exceed the
+  // threshold at the gain carried over from the previous chunk.
+  const int32_t g0 = gainQ12_;
+  const int32_t overLimit = (int32_t)(((int64_t)kLimitThreshold << 12) / g0);
+  int32_t x1 = x1_;
+  int32_t y1 = y1Q8_;
+  int32_t peak = 0;
+  size_t firstOver = n;
+  for (size_t i = 0; i < n; ++i) {
+    const int32_t x = pcm[i];
+    y1 = ((x - x1) << 8) + (int32_t)(((int64_t)dcCoeffQ15_ * (int64_t)y1) >> 15);
+    x1 = x;
+    const int16_t y = sat16((y1 + 128) >> 8);
+    pcm[i] = y;
+    const int32_t a = (y < 0) ? -(int32_t)y : (int32_t)y;
+    if (a > peak) {
+      peak = a;
+      if (a > overLimit && firstOver == n) {
+        firstOver = i;
+      }
+    }
+  }
+  x1_ = x1;
+  y1Q8_ = y1;
+
+  // Chunk gain: AGC target, capped so the chunk peak lands at the limiter threshold.
+  int32_t target = agcGainQ12_;
+  if (peak > 0) {
+    const int32_t limitGain = (int32_t)(((int64_t)kLimitThreshold << 12) / peak);
+    if (limitGain < target) {
+      target = limitGain;
+    }
+  }
+
+  // Pass 2: gain ramp. Reductions complete before the first sample that would overshoot
+  // (look-ahead); the ramp only lowers the gain, so nothing before that sample can exceed
+  // the threshold either. Increases are spread over the whole chunk and rate-limited.
+  size_t rampLen;
+  if (target < g0) {
+    rampLen = (firstOver < kAttackSamples) ? firstOver + 1 : kAttackSamples;
+    if (rampLen > n) {
+      rampLen = n;
+    }
+  } else {
+    target = g0 + (target - g0) / 8;
+    rampLen = n;
+  }
+
+  const int32_t stepQ8 = ((target - g0) * 256) / (int32_t)rampLen;
+  int32_t gQ8 = g0 << 8;
+  for (size_t i = 0; i < rampLen; ++i) {
+    gQ8 += stepQ8;
+    const int32_t g = (i + 1 == rampLen) ? target : (gQ8 >> 8);
+    pcm[i] = sat16((pcm[i] * g) >> 12);
+  }
+  for (size_t i = rampLen; i < n; ++i) {
+    pcm[i] = sat16((pcm[i] * target) >> 12);
+  }
+  gainQ12_ = target;
+}
+
+void CaptureConditioner::updateAgc(float rmsDbfs, float peakDbfs, float clipPercent) {
+  if (clipPercent > 0.0f) {
+    agcDb_ -= 3.0f;
+  } else if (rmsDbfs > kGateRmsDbfs) {
+    // Fast down, slow up: at most -3 / +0.75 dB per chunk; no boost while peaks are near full scale.
+    float step = (kTargetRmsDbfs - rmsDbfs) * 0.25f;
+    const float maxUp = (peakDbfs > -3.0f) ? 0.0f : 0.75f;
+    if (step > maxUp) step = maxUp;
+    if (step < -3.0f) step = -3.0f;
+    agcDb_ += step;
+  }
+
+  if (agcDb_ > kMaxGainDb) agcDb_ = kMaxGainDb;
+  if (agcDb_ < kMinGainDb) agcDb_ = kMinGainDb;
+  agcGainQ12_ = dbToQ12(agcDb_);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// In-place capture conditioning for each recorded chunk (Q15 fixed point, no extra buffers):
+//
+//   1. DC-blocking high-pass  y[n] = x[n] - x[n-1] + a * y[n-1]  (~40 Hz corner)
+//   2. AGC gain, steered once per chunk from the firmware's RMS/peak/clip metrics
+//   3. Look-ahead limiter: the chunk itself is the look-ahead window. Pass 1 finds the
+//      post-DC peak and the first sample that would overshoot at the current gain, pass 2
+//      applies a falling gain ramp that reaches threshold / peak by that sample, so the
+//      output never exceeds the threshold and no per-sample envelope follower is needed.
+//
+// Two passes over int16 data; ~15 cycles/sample on the ESP32-S3.
+class CaptureConditioner {
+ public:
+  static constexpr float kTargetRmsDbfs = -20.0f;
+  static constexpr float kGateRmsDbfs = -58.0f;  // below this AGC holds instead of boosting noise
+  static constexpr float kMaxGainDb = 24.0f;
+  static constexpr float kMinGainDb = -12.0f;
+  static constexpr int32_t kLimitThreshold = 29204;  // -1 dBFS
+  static constexpr size_t kAttackSamples = 32;
+  static constexpr uint32_t kDcCornerHz = 40;
+
+  void configure(uint32_t rateHz);
+  void reset();
+
+  void process(int16_t* pcm, size_t n);
+
+  // Feedback from the output metrics of the chunk just processed.
+  void updateAgc(float rmsDbfs, float peakDbfs, float clipPercent);
+
+  float agcGainDb() const { return agcDb_; }
+  float lastGainDb() const;
+
+ private:
+  int32_t dcCoeffQ15_ = 32400;
+  int32_t x1_ = 0;
+  int32_t y1Q8_ = 0;         // previous DC-blocker output with 8 fractional bits
+  float agcDb_ = 0.0f;
+  int32_t agcGainQ12_ = 4096;
+  int32_t gainQ12_ = 4096;   // gain applied at the end of the previous chunk
+};
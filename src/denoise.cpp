@@ -0,0 +1,164 @@
+#include "denoise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "fft.h"
+
+namespace {
+
+constexpr float kPi = 3.14159265f;
+constexpr int kLog2Frame = 9;
+static_assert((size_t)1 << kLog2Frame == NoiseSuppressor::kFrame, "kLog2Frame must match kFrame");
+constexpr int kInputShift = 14 - kLog2Frame; // int16 -> int32 headroom for log2(kFrame) unscaled stages, one bit spare
+constexpr float kNoiseGate = 2.5f;    // frames below gate x estimate count as noise for that bin
+constexpr float kNoiseTrack = 0.05f;  // averaging step over those frames
+constexpr uint32_t kSeedFrames = 12;  // a fresh profile starts as the plain mean of these
+
+}  // namespace
+
+size_t NoiseSuppressor::bytesFor() {
+  return (kFrame + 2 + kHop) * sizeof(int32_t) + 2 * kBins * sizeof(float) + (2 * kFrame + kHop) * sizeof(int16_t);
+}
+
+bool NoiseSuppressor::init(void* storage, size_t storageBytes, const RealFft* fft) {
+  ready_ = false;
+  if (storage == nullptr || storageBytes < bytesFor() || fft == nullptr || fft->points() != kFrame) {
+    return false;
+  }
+  fft_ = fft;
+  uint8_t* p = (uint8_t*)storage;
+  work_ = (int32_t*)p;
+  p += (kFrame + 2) * sizeof(int32_t);
+  overlap_ = (int32_t*)p;
+  p += kHop * sizeof(int32_t);
+  clean_ = (float*)p;
+  p += kBins * sizeof(float);
+  noise_ = (float*)p;
+  p += kBins * sizeof(float);
+  window_ = (int16_t*)p;
+  p += kFrame * sizeof(int16_t);
+  input_ = (int16_t*)p;
+  p += kFrame * sizeof(int16_t);
+  output_ = (int16_t*)p;
+
+  // Periodic sqrt-Hann: sin(pi n / N). Analysis x synthesis = Hann, which sums to 1 at N/2 hop.
+  for (size_t i = 0; i < kFrame; ++i) {
+    window_[i] = (int16_t)std::min(32767L, lroundf(32768.0f * sinf(kPi * (float)i / (float)kFrame)));
+  }
+  floor_ = powf(10.0f, kGainFloorDb / 20.0f);
+  seeded_ = 0;
+  rateHz_ = 0;
+  ready_ = true;
+  reset();
+  return true;
+}
+
+void NoiseSuppressor::configure(uint32_t rateHz) {
+  if (rateHz == rateHz_ || rateHz == 0) {
+    return;
+  }
+  rateHz_ = rateHz;
+  rise_ = powf(10.0f, kNoiseRiseDbPerSec / 10.0f * (float)kHop / (float)rateHz);
+  seeded_ = 0;
+}
+
+void NoiseSuppressor::reset() {
+  if (!ready_) {
+    return;
+  }
+  memset(overlap_, 0, kHop * sizeof(int32_t));
+  memset(input_, 0, kFrame * sizeof(int16_t));
+  memset(output_, 0, kHop * sizeof(int16_t));
+  fill_ = 0;
+}
+
+void NoiseSuppressor::process(int16_t* pcm, size_t n) {
+  if (!ready_) {
+    return;
+  }
+  while (n > 0) {
+    // Swap this hop's input for the finished output one frame behind it.
+    const size_t take = std::min(n, kHop - fill_);
+    int16_t* in = input_ + kHop + fill_;
+    const int16_t* out = output_ + fill_;
+    for (size_t i = 0; i < take; ++i) {
+      const int16_t x = pcm[i];
+      pcm[i] = out[i];
+      in[i] = x;
+    }
+    pcm += take;
+    n -= take;
+    fill_ += take;
+    if (fill_ == kHop) {
+      runFrame();
+      fill_ = 0;
+    }
+  }
+}
+
+void NoiseSuppressor::runFrame() {
+  for (size_t i = 0; i < kFrame; ++i) {
+    work_[i] = ((int32_t)input_[i] * window_[i]) >> (15 - kInputShift);
+  }
+  fft_->forward(work_);
+
+  // Per-bin Wiener gain xi / (1 + xi), floored, on the decision-directed a-priori SNR xi. A
+  // single frame's power is exponentially distributed, so a fresh profile is seeded from a
+  // mean rather than one frame, then only averages frames that look like noise.
+  const bool primed = seeded_ > 0;
+  for (size_t k = 0; k < kBins; ++k) {
+    const float re = (float)work_[2 * k];
+    const float im = (float)work_[2 * k + 1];
+    const float p = re * re + im * im;
+    float nk = primed ? noise_[k] : p;
+    if (seeded_ < kSeedFrames) {
+      nk += (p - nk) / (float)(seeded_ + 1);
+    } else if (p < kNoiseGate * nk) {
+      nk += kNoiseTrack * (p - nk);
+    } else {
+      nk *= rise_;
+    }
+    noise_[k] = nk;
+    const float inv = 1.0f / std::max(nk, 1.0f);
+    const float excess = std::max(p * inv - 1.0f, 0.0f);
+    const float xi = primed ? kPrioriWeight * clean_[k] * inv + (1.0f - kPrioriWeight) * excess : excess;
+    float g = xi / (1.0f + xi);
+    g = std::max(floor_, std::min(1.0f, g));
+    clean_[k] = g * g * p;
+    const int32_t gQ15 = (int32_t)(g * 32767.0f);
+    work_[2 * k] = (int32_t)(((int64_t)work_[2 * k] * gQ15) >> 15);
+    work_[2 * k + 1] = (int32_t)(((int64_t)work_[2 * k + 1] * gQ15) >> 15);
+  }
+  if (seeded_ < kSeedFrames) {
+    ++seeded_;
+  }
+
+  fft_->inverse(work_);
+
+  // inverse() returns (N/2) * x << kInputShift; fold that into the synthesis window product.
+  static constexpr int kOutShift = 15 + kInputShift + kLog2Frame - 1; // log2(kFrame / 2)
+  static constexpr int64_t kRound = (int64_t)1 << (kOutShift - 1);
+  for (size_t i = 0; i < kHop; ++i) {
+    const int32_t head = (int32_t)(((int64_t)work_[i] * window_[i] + kRound) >> kOutShift);
+    const int32_t v = overlap_[i] + head;
+    output_[i] = (int16_t)std::max(-32768, std::min(32767, v));
+    overlap_[i] = (int32_t)(((int64_t)work_[kHop + i] * window_[kHop + i] + kRound) >> kOutShift);
+  }
+  memmove(input_, input_ + kHop, kHop * sizeof(int16_t));
+}
+
+float NoiseSuppressor::noiseDbfs() const {
+  if (!ready_ || seeded_ == 0) {
+    return -99.9f;
+  }
+  // Parseval over the one-sided spectrum, normalized by the analysis window energy (N/2).
+  double sum = noise_[0] + noise_[kBins - 1];
+  for (size_t k = 1; k + 1 < kBins; ++k) {
+    sum += 2.0 * noise_[k];
+  }
+  const double scale = 32768.0 * (double)(1 << kInputShift);
+  const double meanSquare = sum / ((double)kFrame * (double)kFrame * 0.5) / (scale * scale);
+  return (meanSquare > 0.0) ? (float)(10.0 * log10(meanSquare)) : -99.9f;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class RealFft;
+
+// Streaming STFT noise suppression for captured chunks, in place. 512-point frames at 50%
+// overlap with a sqrt-Hann window on both sides (the products sum to one), a Wiener gain per
+// bin on a decision-directed a-priori SNR (this frame's excess power blended with the previous
+// frame's cleaned power, which keeps the residual from "musical" flicker) and overlap-add
+// resynthesis. 512 points resolve voice harmonics (31 Hz bins at 16 kHz) so noise between
+// them can be taken out; 256 points measured ~1 dB less gain. Constant noise (fans, mains hum) is
+// learned per bin from frames that stay near the current estimate; louder frames only let it
+// creep up at kNoiseRiseDbPerSec, so speech never pulls it up. The profile outlives a take, so
+// the next one starts with it.
+//
+// Output lags input by kLatencySamples (the first take of a stream starts with that much
+// silence; the last input frame stays in the pipeline). FFT data is int32 via the shared
+// RealFft; the per-bin gain uses floats (two divisions per bin and frame). Budget: ~300 cycles
+// per sample on the ESP32-S3, about 2% of one core at 16 kHz.
+class NoiseSuppressor {
+ public:
+  static constexpr size_t kFrame = 512;
+  static constexpr size_t kHop = kFrame / 2;
+  static constexpr size_t kBins = kFrame / 2 + 1;
+  static constexpr size_t kLatencySamples = kFrame;
+  static constexpr uint32_t kBudgetCycles = 300;
+
+  static constexpr float kPrioriWeight = 0.9f;      // share of the previous frame in the a-priori SNR
+  static constexpr float kGainFloorDb = -20.0f;     // residual noise kept to mask musical tones
+  static constexpr float kNoiseRiseDbPerSec = 3.0f;
+
+  static size_t bytesFor();
+
+  // Caller owns storage (bytesFor()); fft must stay configured for kFrame points.
+  bool init(void* storage, size_t storageBytes, const RealFft* fft);
+  bool isReady() const { return ready_; }
+
+  // Sets the capture rate; the noise profile is kept unless the rate changes.
+  void configure(uint32_t rateHz);
+  // Clears the stream (history, overlap, pending output) but keeps the noise profile.
+  void reset();
+
+  void process(int16_t* pcm, size_t n);
+
+  // Learned noise level as a full-band RMS in dBFS (-99.9 before the first frame).
+  float noiseDbfs() const;
+
+ private:
+  void runFrame();
+
+  const RealFft* fft_ = nullptr;
+  int32_t* work_ = nullptr;   // kFrame + 2
+  int32_t* overlap_ = nullptr; // kHop, second half of the previous frame's output
+  float* clean_ = nullptr;    // kBins, previous frame's cleaned power (gain^2 * power)
+  float* noise_ = nullptr;    // kBins, noise power estimate
+  int16_t* window_ = nullptr; // kFrame, sqrt-Hann Q15
+  int16_t* input_ = nullptr;  // kFrame, last frame of input
+  int16_t* output_ = nullptr; // kHop, finished samples waiting to go out
+  size_t fill_ = 0;
+  uint32_t rateHz_ = 0;
+  float rise_ = 1.0f;         // per-frame noise rise factor
+  float floor_ = 1.0f;        // kGainFloorDb as a linear gain
+  uint32_t seeded_ = 0;       // frames in the profile, up to the seed count
+  bool ready_ = false;
+};
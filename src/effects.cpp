@@ -0,0 +1,372 @@
+#include "effects.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Freeverb tunings at 44.1 kHz, scaled to the clip rate (mutually prime lengths).
+constexpr size_t kCombBase[ReverbEffect::kCombs] = {1116, 1188, 1277, 1356};
+constexpr size_t kAllpassBase[ReverbEffect::kAllpasses] = {556, 441};
+constexpr uint32_t kTuningRateHz = 44100;
+constexpr uint32_t kMaxTailMs = 4000;
+constexpr size_t kReverbChunk = 64;
+// Feedback products round to nearest: truncation biases every pass toward -1 and leaves the
+// tails idling in a small limit cycle instead of decaying to zero.
+constexpr int32_t kRound = 1 << 14;
+
+size_t scaled(size_t base, uint32_t rateHz) {
+  return std::max<size_t>(1, (base * rateHz) / kTuningRateHz);
+}
+
+size_t echoSamplesFor(uint32_t rateHz) {
+  return (size_t)(((uint64_t)EchoEffect::kMaxDelayMs * rateHz) / 1000u);
+}
+
+int16_t saturate16(int32_t v) {
+  if (v > 32767) return 32767;
+  if (v < -32768) return -32768;
+  return (int16_t)v;
+}
+
+// Samples until a loop with this per-pass gain decays by 60 dB, capped.
+uint32_t decaySamples(uint32_t loopSamples, int32_t gainQ15, uint32_t rateHz) {
+  if (gainQ15 <= 0) {
+    return loopSamples;
+  }
+  const float passes = logf(0.001f) / logf((float)gainQ15 / 32768.0f);
+  return std::min((uint32_t)((float)loopSamples * (passes + 1.0f)), (uint32_t)(((uint64_t)kMaxTailMs * rateHz) / 1000u));
+}
+
+}  // namespace
+
+const EchoPreset kEchoPresets[] = {
+  {"off", 0, 0, 0, 0},
+  {"slapback 110ms", 110, 8192, 14746, 6554},
+  {"echo 250ms", 250, 14746, 13107, 9830},
+  {"canyon 420ms", 420, 19661, 13107, 13107},
+};
+const size_t kEchoPresetCount = sizeof(kEchoPresets) / sizeof(kEchoPresets[0]);
+
+const ReverbPreset kReverbPresets[] = {
+  {"off", 0, 0, 0},
+  {"room", 25559, 13107, 9830},
+  {"hall", 28180, 8192, 13107},
+};
+const size_t kReverbPresetCount = sizeof(kReverbPresets) / sizeof(kReverbPresets[0]);
+
+const PitchPreset kPitchPresets[] = {
+  {"off", 0},
+  {"+5 st", 5},
+  {"+12 st", 12},
+  {"-5 st", -5},
+  {"-12 st", -12},
+};
+const size_t kPitchPresetCount = sizeof(kPitchPresets) / sizeof(kPitchPresets[0]);
+
+// --- Echo ---
+
+void EchoEffect::attach(int16_t* line, size_t capacity) {
+  line_ = line;
+  cap_ = (line != nullptr) ? capacity : 0;
+  len_ = 0;
+}
+
+void EchoEffect::configure(uint32_t rateHz, const EchoPreset& p) {
+  const size_t len = (size_t)(((uint64_t)std::min<uint32_t>(p.delayMs, kMaxDelayMs) * rateHz) / 1000u);
+  len_ = (p.feedbackQ15 > 0 || p.mixQ15 > 0) ? std::min(len, cap_) : 0;
+  fb_ = std::min<int32_t>(p.feedbackQ15, 31130); // < 0.95: always decays
+  mix_ = p.mixQ15;
+  damp_ = 32768 - std::min<int32_t>(p.dampQ15, 32767);
+  rateHz_ = rateHz;
+  reset();
+}
+
+void EchoEffect::reset() {
+  pos_ = 0;
+  lp_ = 0;
+  if (len_ > 0) {
+    memset(line_, 0, len_ * sizeof(int16_t));
+  }
+}
+
+void EchoEffect::process(int16_t* buf, size_t n) {
+  if (len_ == 0) {
+    return;
+  }
+  const int32_t fb = fb_;
+  const int32_t mix = mix_;
+  const int32_t damp = damp_;
+  int32_t lp = lp_;
+  size_t k = 0;
+  // Segments end at the line's wrap point, so the inner loop has no index checks.
+  while (k < n) {
+    const size_t seg = std::min(n - k, len_ - pos_);
+    int16_t* line = line_ + pos_;
+    int16_t* io = buf + k;
+    for (size_t i = 0; i < seg; ++i) {
+      const int32_t x = io[i];
+      const int32_t d = line[i];
+      lp += ((d - lp) * damp + kRound) >> 15;
+      line[i] = saturate16(x + ((lp * fb + kRound) >> 15));
+      io[i] = saturate16(x + ((d * mix) >> 15));
+    }
+    pos_ += seg;
+    if (pos_ == len_) {
+      pos_ = 0;
+    }
+    k += seg;
+  }
+  lp_ = lp;
+}
+
+uint32_t EchoEffect::tailSamples() const {
+  return (len_ > 0) ? decaySamples((uint32_t)len_, fb_, rateHz_) : 0;
+}
+
+// --- Reverb ---
+
+size_t ReverbEffect::samplesFor(uint32_t rateHz) {
+  size_t total = 0;
+  for (size_t base : kCombBase) {
+    total += scaled(base, rateHz);
+  }
+  for (size_t base : kAllpassBase) {
+    total += scaled(base, rateHz);
+  }
+  return total;
+}
+
+void ReverbEffect::attach(int16_t* lines, size_t capacity) {
+  lines_ = lines;
+  cap_ = (lines != nullptr) ? capacity : 0;
+  fb_ = 0;
+}
+
+void ReverbEffect::configure(uint32_t rateHz, const ReverbPreset& p) {
+  fb_ = 0;
+  rateHz_ = rateHz;
+  if (p.feedbackQ15 == 0 || samplesFor(rateHz) > cap_) {
+    return;
+  }
+  int16_t* next = lines_;
+  for (size_t i = 0; i < kCombs; ++i) {
+    comb_[i].buf = next;
+    comb_[i].len = scaled(kCombBase[i], rateHz);
+    next += comb_[i].len;
+  }
+  for (size_t i = 0; i < kAllpasses; ++i) {
+    allpass_[i].buf = next;
+    allpass_[i].len = scaled(kAllpassBase[i], rateHz);
+    next += allpass_[i].len;
+  }
+  fb_ = std::min<int32_t>(p.feedbackQ15, 31130);
+  damp_ = std::min<int32_t>(p.dampQ15, 32767);
+  mix_ = p.mixQ15;
+  reset();
+}
+
+void ReverbEffect::reset() {
+  if (fb_ == 0) {
+    return;
+  }
+  for (size_t i = 0; i < kCombs; ++i) {
+    memset(comb_[i].buf, 0, comb_[i].len * sizeof(int16_t));
+    comb_[i].pos = 0;
+    combLp_[i] = 0;
+  }
+  for (size_t i = 0; i < kAllpasses; ++i) {
+    memset(allpass_[i].buf, 0, allpass_[i].len * sizeof(int16_t));
+    allpass_[i].pos = 0;
+  }
+}
+
+void ReverbEffect::process(int16_t* buf, size_t n) {
+  if (fb_ == 0) {
+    return;
+  }
+  // Line-major over short chunks: each comb/all-pass walks its own line in wrap-free
+  // segments, accumulating into a small int32 scratch.
+  int32_t acc[kReverbChunk];
+  for (size_t base = 0; base < n; base += kReverbChunk) {
+    const size_t m = std::min(kReverbChunk, n - base);
+    int16_t* io = buf + base;
+    memset(acc, 0, m * sizeof(acc[0]));
+
+    for (size_t c = 0; c < kCombs; ++c) {
+      Line& line = comb_[c];
+      int32_t lp = combLp_[c];
+      size_t k = 0;
+      while (k < m) {
+        const size_t seg = std::min(m - k, line.len - line.pos);
+        int16_t* d = line.buf + line.pos;
+        for (size_t i = 0; i < seg; ++i) {
+          const int32_t o = d[i];
+          lp = o + (((lp - o) * damp_ + kRound) >> 15);
+          d[i] = saturate16((io[k + i] >> 2) + ((lp * fb_ + kRound) >> 15));
+          acc[k + i] += o;
+        }
+        line.pos += seg;
+        if (line.pos == line.len) {
+          line.pos = 0;
+        }
+        k += seg;
+      }
+      combLp_[c] = lp;
+    }
+
+    for (size_t i = 0; i < m; ++i) {
+      acc[i] >>= 2;
+    }
+    for (size_t a = 0; a < kAllpasses; ++a) {
+      Line& line = allpass_[a];
+      size_t k = 0;
+      while (k < m) {
+        const size_t seg = std::min(m - k, line.len - line.pos);
+        int16_t* d = line.buf + line.pos;
+        for (size_t i = 0; i < seg; ++i) {
+          const int32_t v = acc[k + i];
+          const int32_t o = d[i];
+          d[i] = saturate16(v + (o >> 1));
+          acc[k + i] = o - v;
+        }
+        line.pos += seg;
+        if (line.pos == line.len) {
+          line.pos = 0;
+        }
+        k += seg;
+      }
+    }
+
+    for (size_t i = 0; i < m; ++i) {
+      io[i] = saturate16(io[i] + ((saturate16(acc[i]) * mix_) >> 15));
+    }
+  }
+}
+
+uint32_t ReverbEffect::tailSamples() const {
+  if (fb_ == 0) {
+    return 0;
+  }
+  return decaySamples((uint32_t)comb_[kCombs - 1].len, fb_, rateHz_) + (uint32_t)(allpass_[0].len + allpass_[1].len);
+}
+
+// --- Pitch shift ---
+
+void PitchShiftEffect::attach(int16_t* line, size_t capacity) {
+  line_ = (capacity >= kLineSamples) ? line : nullptr;
+  step_ = 0;
+}
+
+void PitchShiftEffect::configure(uint32_t rateHz, const PitchPreset& p) {
+  step_ = 0;
+  if (line_ == nullptr || p.semitones == 0) {
+    return;
+  }
+  window_ = std::min<uint32_t>((uint32_t)(((uint64_t)kWindowMs * rateHz) / 1000u), kLineSamples - 2);
+  const float ratio = powf(2.0f, (float)p.semitones / 12.0f);
+  step_ = (int32_t)lrintf((1.0f - ratio) * 65536.0f);
+  reset();
+}
+
+void PitchShiftEffect::reset() {
+  if (line_ != nullptr) {
+    memset(line_, 0, kLineSamples * sizeof(int16_t));
+  }
+  pos_ = 0;
+  delayQ16_ = 0;
+}
+
+int32_t PitchShiftEffect::tap(uint32_t delayQ16) const {
+  // Linear interpolation between the samples delayQ16 and delayQ16 + 1 back.
+  const size_t i0 = (pos_ - (delayQ16 >> 16)) & (kLineSamples - 1);
+  const size_t i1 = (i0 - 1) & (kLineSamples - 1);
+  const int32_t frac = (int32_t)((delayQ16 >> 1) & 0x7FFF);
+  const int32_t a = line_[i0];
+  return a + (((line_[i1] - a) * frac) >> 15);
+}
+
+void PitchShiftEffect::process(int16_t* buf, size_t n) {
+  if (step_ == 0) {
+    return;
+  }
+  const uint32_t windowQ16 = window_ << 16;
+  const uint32_t halfQ16 = windowQ16 / 2;
+  // Tap gain is a triangle over the window (0 at the ends, full scale in the middle); the
+  // second tap's gain is its complement, so the cross-fade keeps unity level.
+  const uint64_t gainScale = ((uint64_t)32768 << 32) / halfQ16;
+  for (size_t k = 0; k < n; ++k) {
+    line_[pos_] = buf[k];
+    const uint32_t d1 = delayQ16_;
+    const uint32_t d2 = (d1 >= halfQ16) ? d1 - halfQ16 : d1 + halfQ16;
+    const uint32_t edge = std::min(d1, windowQ16 - d1);
+    const int32_t g1 = (int32_t)std::min<uint64_t>(32768, ((uint64_t)edge * gainScale) >> 32);
+    const int32_t t1 = tap(d1);
+    const int32_t t2 = tap(d2);
+    buf[k] = saturate16(t2 + (((t1 - t2) * g1) >> 15));
+
+    int32_t next = (int32_t)d1 + step_;
+    if (next < 0) {
+      next += (int32_t)windowQ16;
+    } else if ((uint32_t)next >= windowQ16) {
+      next -= (int32_t)windowQ16;
+    }
+    delayQ16_ = (uint32_t)next;
+    pos_ = (pos_ + 1) & (kLineSamples - 1);
+  }
+}
+
+// --- Chain ---
+
+size_t EffectsChain::bytesFor(uint32_t maxRateHz) {
+  return (echoSamplesFor(maxRateHz) + ReverbEffect::samplesFor(maxRateHz) + PitchShiftEffect::kLineSamples) * sizeof(int16_t);
+}
+
+bool EffectsChain::init(void* storage, size_t storageBytes) {
+  ready_ = false;
+  if (storage == nullptr || storageBytes < bytesFor(kMaxRateHz)) {
+    return false;
+  }
+  int16_t* next = static_cast<int16_t*>(storage);
+  echo_.attach(next, echoSamplesFor(kMaxRateHz));
+  next += echoSamplesFor(kMaxRateHz);
+  reverb_.attach(next, ReverbEffect::samplesFor(kMaxRateHz));
+  next += ReverbEffect::samplesFor(kMaxRateHz);
+  pitch_.attach(next, PitchShiftEffect::kLineSamples);
+  ready_ = true;
+  return true;
+}
+
+void EffectsChain::select(size_t echo, size_t reverb, size_t pitch) {
+  echoIdx_ = std::min(echo, kEchoPresetCount - 1);
+  reverbIdx_ = std::min(reverb, kReverbPresetCount - 1);
+  pitchIdx_ = std::min(pitch, kPitchPresetCount - 1);
+}
+
+void EffectsChain::start(uint32_t rateHz) {
+  if (!ready_) {
+    return;
+  }
+  rateHz = std::min(rateHz, kMaxRateHz);
+  pitch_.configure(rateHz, kPitchPresets[pitchIdx_]);
+  echo_.configure(rateHz, kEchoPresets[echoIdx_]);
+  reverb_.configure(rateHz, kReverbPresets[reverbIdx_]);
+}
+
+uint32_t EffectsChain::tailSamples() const {
+  if (!ready_) {
+    return 0;
+  }
+  // The stages run in series, so their tails add up.
+  return pitch_.tailSamples() + echo_.tailSamples() + reverb_.tailSamples();
+}
+
+void EffectsChain::process(int16_t* buf, size_t n) {
+  if (!enabled() || buf == nullptr) {
+    return;
+  }
+  pitch_.process(buf, n);
+  echo_.process(buf, n);
+  reverb_.process(buf, n);
+}
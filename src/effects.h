@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Playback effects: pitch shift -> feedback echo -> reverb, applied in place to the clip
+// stream block by block (int16 samples, Q15 coefficients, int32 math, no floats per sample).
+//
+// All delay lines live in one caller-owned buffer (PSRAM is fine: every line is walked
+// sequentially, so the cache sees streaming access). Each effect documents its budget in
+// cycles per sample on the ESP32-S3; the bench build checks them. The budgets add up to
+// ~150 cycles, i.e. ~2% of one 240 MHz core at 32 kHz with all three effects on.
+
+struct EchoPreset {
+  const char* name;
+  uint16_t delayMs;  // 0 = off
+  uint16_t feedbackQ15;
+  uint16_t mixQ15;
+  uint16_t dampQ15;  // one-pole low-pass in the feedback path; 0 = none, higher = darker repeats
+};
+
+struct ReverbPreset {
+  const char* name;
+  uint16_t feedbackQ15; // comb feedback (room size); 0 = off
+  uint16_t dampQ15;
+  uint16_t mixQ15;
+};
+
+struct PitchPreset {
+  const char* name;
+  int8_t semitones;  // 0 = off
+};
+
+extern const EchoPreset kEchoPresets[];
+extern const size_t kEchoPresetCount;
+extern const ReverbPreset kReverbPresets[];
+extern const size_t kReverbPresetCount;
+extern const PitchPreset kPitchPresets[];
+extern const size_t kPitchPresetCount;
+
+// Feedback delay; repeats fade by feedback per pass and lose highs through the damping filter.
+class EchoEffect {
+ public:
+  static constexpr uint32_t kBudgetCycles = 25;
+  static constexpr uint32_t kMaxDelayMs = 500;
+
+  void attach(int16_t* line, size_t capacity);
+  void configure(uint32_t rateHz, const EchoPreset& p);
+  void reset();
+  void process(int16_t* buf, size_t n);
+  bool enabled() const { return len_ > 0; }
+  // Samples until the repeats fall below -60 dB.
+  uint32_t tailSamples() const;
+
+ private:
+  int16_t* line_ = nullptr;
+  size_t cap_ = 0;
+  size_t len_ = 0;
+  size_t pos_ = 0;
+  int32_t fb_ = 0;
+  int32_t mix_ = 0;
+  int32_t damp_ = 0;
+  int32_t lp_ = 0;
+  uint32_t rateHz_ = 0;
+};
+
+// Schroeder/Freeverb-style: four damped parallel combs into two series all-passes.
+class ReverbEffect {
+ public:
+  static constexpr uint32_t kBudgetCycles = 90;
+  static constexpr size_t kCombs = 4;
+  static constexpr size_t kAllpasses = 2;
+
+  // Delay-line samples needed at rateHz.
+  static size_t samplesFor(uint32_t rateHz);
+
+  void attach(int16_t* lines, size_t capacity);
+  void configure(uint32_t rateHz, const ReverbPreset& p);
+  void reset();
+  void process(int16_t* buf, size_t n);
+  bool enabled() const { return fb_ > 0; }
+  uint32_t tailSamples() const;
+
+ private:
+  struct Line {
+    int16_t* buf = nullptr;
+    size_t len = 0;
+    size_t pos = 0;
+  };
+
+  int16_t* lines_ = nullptr;
+  size_t cap_ = 0;
+  Line comb_[kCombs];
+  Line allpass_[kAllpasses];
+  int32_t combLp_[kCombs] = {0};
+  int32_t fb_ = 0;
+  int32_t damp_ = 0;
+  int32_t mix_ = 0;
+  uint32_t rateHz_ = 0;
+};
+
+// Delay-line ("rotating head") pitch shifter: two taps sweep a ~40 ms window half a window
+// apart and cross-fade, so the clip keeps its length while the pitch moves.
+class PitchShiftEffect {
+ public:
+  static constexpr uint32_t kBudgetCycles = 40;
+  static constexpr size_t kLineSamples = 2048; // power of two; holds the window at 32 kHz
+  static constexpr uint32_t kWindowMs = 40;
+
+  void attach(int16_t* line, size_t capacity);
+  void configure(uint32_t rateHz, const PitchPreset& p);
+  void reset();
+  void process(int16_t* buf, size_t n);
+  bool enabled() const { return step_ != 0; }
+  uint32_t tailSamples() const { return enabled() ? window_ : 0; }
+
+ private:
+  int32_t tap(uint32_t delayQ16) const;
+
+  int16_t* line_ = nullptr;
+  size_t pos_ = 0;
+  uint32_t window_ = 0;   // samples
+  uint32_t delayQ16_ = 0; // first tap's delay; the second is half a window further
+  int32_t step_ = 0;      // delay change per sample, Q16 (1 - ratio)
+};
+
+class EffectsChain {
+ public:
+  static constexpr uint32_t kMaxRateHz = 32000;
+  static constexpr uint32_t kBudgetCycles = EchoEffect::kBudgetCycles + ReverbEffect::kBudgetCycles + PitchShiftEffect::kBudgetCycles;
+
+  static size_t bytesFor(uint32_t maxRateHz);
+
+  // Caller owns storage (bytesFor(kMaxRateHz)); false if it is too small.
+  bool init(void* storage, size_t storageBytes);
+  bool isReady() const { return ready_; }
+
+  // Preset indices into kEchoPresets / kReverbPresets / kPitchPresets.
+  void select(size_t echo, size_t reverb, size_t pitch);
+  // Applies the selected presets at the clip rate and clears the delay lines.
+  void start(uint32_t rateHz);
+  bool enabled() const { return ready_ && (echoIdx_ | reverbIdx_ | pitchIdx_) != 0; }
+  // Silence to feed after the clip so echoes and reverb ring out.
+  uint32_t tailSamples() const;
+
+  void process(int16_t* buf, size_t n);
+
+  EchoEffect& echo() { return echo_; }
+  ReverbEffect& reverb() { return reverb_; }
+  PitchShiftEffect& pitch() { return pitch_; }
+
+ private:
+  EchoEffect echo_;
+  ReverbEffect reverb_;
+  PitchShiftEffect pitch_;
+  size_t echoIdx_ = 0;
+  size_t reverbIdx_ = 0;
+  size_t pitchIdx_ = 0;
+  bool ready_ = false;
+};
@@ -0,0 +1,122 @@
+#include "fft.h"
+
+#include <cmath>
+#include <utility>
+
+namespace {
+
+inline int32_t mulQ30(int32_t a, int32_t b) {
+  return (int32_t)(((int64_t)a * b + (1 << 29)) >> 30);
+}
+
+}  // namespace
+
+bool RealFft::configure(size_t points) {
+  if (points < 16 || points > kMaxPoints || (points & (points - 1)) != 0) {
+    return false;
+  }
+  n_ = points;
+  const size_t half = points / 2;
+  log2Half_ = 0;
+  while ((1u << log2Half_) < half) {
+    ++log2Half_;
+  }
+  for (size_t k = 0; k < half; ++k) {
+    const double a = 2.0 * 3.14159265358979323846 * (double)k / (double)points;
+    cos_[k] = (int32_t)lround(cos(a) * 1073741824.0);
+    sin_[k] = (int32_t)lround(sin(a) * 1073741824.0);
+    size_t r = 0;
+    for (uint8_t b = 0; b < log2Half_; ++b) {
+      r |= ((k >> b) & 1u) << (log2Half_ - 1 - b);
+    }
+    rev_[k] = (uint16_t)r;
+  }
+  return true;
+}
+
+// Iterative radix-2 decimation in time on n_/2 interleaved (re, im) points. Twiddles for the
+// half-size transform are every other entry of the N-point table.
+void RealFft::complexFft(int32_t* z, bool inverse) const {
+  const size_t m = n_ / 2;
+  for (size_t i = 0; i < m; ++i) {
+    const size_t j = rev_[i];
+    if (j > i) {
+      std::swap(z[2 * i], z[2 * j]);
+      std::swap(z[2 * i + 1], z[2 * j + 1]);
+    }
+  }
+  for (size_t span = 1; span < m; span <<= 1) {
+    const size_t step = n_ / (2 * span); // W_(2*span)^j = W_N^(j*step)
+    for (size_t j = 0; j < span; ++j) {
+      const int32_t wr = cos_[j * step];
+      const int32_t wi = inverse ? sin_[j * step] : -sin_[j * step];
+      for (size_t i = j; i < m; i += 2 * span) {
+        int32_t* a = z + 2 * i;
+        int32_t* b = z + 2 * (i + span);
+        const int32_t tr = mulQ30(b[0], wr) - mulQ30(b[1], wi);
+        const int32_t ti = mulQ30(b[0], wi) + mulQ30(b[1], wr);
+        b[0] = a[0] - tr;
+        b[1] = a[1] - ti;
+        a[0] += tr;
+        a[1] += ti;
+      }
+    }
+  }
+}
+
+void RealFft::forward(int32_t* buf) const {
+  // Even/odd samples as one complex sequence z[m] = x[2m] + i x[2m+1].
+  complexFft(buf, false);
+  const size_t m = n_ / 2;
+
+  // Split: Ze = (Z[k] + conj Z[m-k]) / 2, Zo = -i (Z[k] - conj Z[m-k]) / 2,
+  // X[k] = Ze + W^k Zo and X[m-k] = conj(Ze - W^k Zo).
+  const int32_t z0r = buf[0];
+  const int32_t z0i = buf[1];
+  buf[0] = z0r + z0i;
+  buf[1] = 0;
+  buf[2 * m] = z0r - z0i;
+  buf[2 * m + 1] = 0;
+  for (size_t k = 1; k <= m / 2; ++k) {
+    int32_t* a = buf + 2 * k;
+    int32_t* b = buf + 2 * (m - k);
+    const int32_t er = (a[0] >> 1) + (b[0] >> 1);
+    const int32_t ei = (a[1] >> 1) - (b[1] >> 1);
+    const int32_t orr = (a[1] >> 1) + (b[1] >> 1);
+    const int32_t oi = (b[0] >> 1) - (a[0] >> 1);
+    // W^k = cos - i sin
+    const int32_t tr = mulQ30(orr, cos_[k]) + mulQ30(oi, sin_[k]);
+    const int32_t ti = mulQ30(oi, cos_[k]) - mulQ30(orr, sin_[k]);
+    a[0] = er + tr;
+    a[1] = ei + ti;
+    b[0] = er - tr;
+    b[1] = ti - ei;
+  }
+}
+
+void RealFft::inverse(int32_t* buf) const {
+  const size_t m = n_ / 2;
+
+  // Undo the split: Ze = (X[k] + conj X[m-k]) / 2, Zo = conj(W^k) (X[k] - conj X[m-k]) / 2,
+  // Z[k] = Ze + i Zo and Z[m-k] = conj(Ze) + i conj(Zo).
+  const int32_t x0 = buf[0];
+  const int32_t xm = buf[2 * m];
+  buf[0] = (x0 >> 1) + (xm >> 1);
+  buf[1] = (x0 >> 1) - (xm >> 1);
+  for (size_t k = 1; k <= m / 2; ++k) {
+    int32_t* a = buf + 2 * k;
+    int32_t* b = buf + 2 * (m - k);
+    const int32_t er = (a[0] >> 1) + (b[0] >> 1);
+    const int32_t ei = (a[1] >> 1) - (b[1] >> 1);
+    const int32_t dr = (a[0] >> 1) - (b[0] >> 1);
+    const int32_t di = (a[1] >> 1) + (b[1] >> 1);
+    // conj(W^k) = cos + i sin
+    const int32_t orr = mulQ30(dr, cos_[k]) - mulQ30(di, sin_[k]);
+    const int32_t oi = mulQ30(dr, sin_[k]) + mulQ30(di, cos_[k]);
+    a[0] = er - oi;
+    a[1] = ei + orr;
+    b[0] = er + oi;
+    b[1] = orr - ei;
+  }
+  complexFft(buf, true);
+}
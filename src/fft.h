@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Shared fixed-point FFT engine for real signals. An N-point real transform runs as an
+// N/2-point complex radix-2 FFT plus a split pass, in place on int32 data with Q30 twiddles.
+// There is no per-stage scaling: each of the log2(N) stages can double magnitudes, so callers
+// leave that many bits of headroom (int16 input shifted left by 6 fits N = 256 with a spare
+// bit). configure() builds the tables once; the transforms are const and work on caller
+// buffers, so one engine serves every user of the same size.
+class RealFft {
+ public:
+  static constexpr size_t kMaxPoints = 512;
+
+  // points: power of two in 16..kMaxPoints.
+  bool configure(size_t points);
+  size_t points() const { return n_; }
+
+  // buf[0..N) real samples -> buf[0..N+2) bins 0..N/2 as (re, im); unnormalized DFT.
+  void forward(int32_t* buf) const;
+  // Inverse of forward(): bins 0..N/2 in buf[0..N+2) -> buf[0..N) real samples times N/2.
+  void inverse(int32_t* buf) const;
+
+ private:
+  void complexFft(int32_t* z, bool inverse) const;
+
+  size_t n_ = 0;
+  uint8_t log2Half_ = 0;
+  int32_t cos_[kMaxPoints / 2] = {0}; // cos(2*pi*k/N), Q30
+  int32_t sin_[kMaxPoints / 2] = {0}; // sin(2*pi*k/N), Q30
+  uint16_t rev_[kMaxPoints / 2] = {0}; // bit reversal over N/2 complex points
+};
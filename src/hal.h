@@ -0,0 +1,148 @@
+#pragma once
+
+// Thin hardware abstraction over the M5Unified/Arduino calls the firmware uses.
+//
+// The port objects mirror the M5Unified subset in use (hal::Mic.record(), hal::BtnA.isPressed(),
+// ...) so call sites read like the original code. Backends:
+//   - hal_m5.cpp:  StickS3 via M5Unified (default build)
+//   - hal_sim.cpp: headless Linux simulator (AXES_ECHO_SIM=1, `native-sim` environment) with a
+//                  simulated clock, file-fed mic/IMU traces, scripted buttons and frame dumps.
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef AXES_ECHO_SIM
+#define AXES_ECHO_SIM 0
+#endif
+
+#if AXES_ECHO_SIM
+#include <M5GFX.h>
+#else
+#include <Arduino.h>
+#include <M5Unified.h>
+#endif
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+namespace hal {
+
+void begin();
+void update(); // buttons (and other polled inputs); call once per loop()
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+// Idles until the millis() deadline. With allowLightSleep the core may enter light sleep
+// when at least kLightSleepMinMs remain; a KEY1/KEY2 press wakes it early (GPIO wakeup), so
+// the caller returns before the deadline and sees the edge on the next update().
+constexpr uint32_t kLightSleepMinMs = 10;
+void sleepUntil(uint32_t deadlineMs, bool allowLightSleep);
+uint32_t cycleCount();
+uint32_t cpuFreqMHz();
+
+void logf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// I2C transactions issued through the ports (PMIC reads, IMU updates) since boot.
+uint32_t i2cTransactions();
+
+uint32_t freeHeap();
+uint32_t freePsram();
+void* allocLarge(size_t bytes); // PSRAM preferred, heap fallback; nullptr on failure
+
+// Memory telemetry in bytes: low-water marks since boot, and the largest single block that
+// could be allocated now (well below free = fragmented).
+uint32_t minFreeHeap();
+uint32_t largestFreeHeapBlock();
+uint32_t minFreePsram();
+uint32_t largestFreePsramBlock();
+
+// Stack headroom per task (minimum free bytes ever), tightest first; returns the count.
+struct TaskStackInfo {
+  char name[16];
+  uint32_t minFreeBytes;
+};
+size_t taskStacks(TaskStackInfo* out, size_t cap);
+
+// Idle time per core since boot (light sleep counts as idle), for load = 1 - dIdle / dt. On
+// the device it comes from cycle-stamped idle hooks (or the IDLE tasks' run-time counters when
+// FreeRTOS run-time stats are compiled in); cpuIdleMeasured() is false if the hooks could not
+// be registered, and cpuIdleUs() then only covers light sleep.
+uint8_t cpuCoreCount();
+bool cpuIdleMeasured();
+uint64_t cpuIdleUs(uint8_t core);
+
+class DisplayPort {
+ public:
+  int width() const;
+  int height() const;
+  void setRotation(uint8_t rot);
+  void fillScreen(uint16_t color);
+  void pushFrame(lgfx::LGFX_Sprite& frame);
+};
+
+class MicPort {
+ public:
+  bool isEnabled() const;
+  bool isRunning() const;
+  void end();
+  // Enqueues a capture of `samples` into buf; poll isRecording() until it is filled.
+  bool record(int16_t* buf, size_t samples, uint32_t rateHz);
+  bool isRecording() const;
+};
+
+class SpeakerPort {
+ public:
+  bool isEnabled() const;
+  bool isRunning() const;
+  bool begin();
+  void stop();
+  void end();
+  void setVolume(uint8_t volume);
+  bool tone(float hz, uint32_t ms);
+  // Queues buf behind whatever is playing on `channel` (buf must stay valid until played).
+  bool playRaw(const int16_t* buf, size_t samples, uint32_t rateHz, uint8_t channel);
+  size_t isPlaying() const;
+  size_t isPlaying(uint8_t channel) const; // 0 idle, 1 playing, 2 playing + queued
+};
+
+class ImuPort {
+ public:
+  bool isEnabled() const;
+  bool update();
+  bool getAccel(float* ax, float* ay, float* az);
+};
+
+class PowerPort {
+ public:
+  int32_t getBatteryLevel();
+  int16_t getBatteryVoltage();
+  bool isCharging();
+};
+
+class ButtonPort {
+ public:
+  explicit ButtonPort(uint8_t id) : id_(id) {}
+  bool isPressed() const;
+  bool wasPressed() const;
+  bool wasReleased() const;
+  bool wasClicked() const;
+  bool pressedFor(uint32_t ms) const;
+  // micros() when update() saw the latest press or release (for latency tracing).
+  uint32_t edgeUs() const;
+
+ private:
+  uint8_t id_;
+};
+
+extern DisplayPort Display;
+extern MicPort Mic;
+extern SpeakerPort Speaker;
+extern ImuPort Imu;
+extern PowerPort Power;
+extern ButtonPort BtnA;
+extern ButtonPort BtnB;
+
+}  // namespace hal
@@ -0,0 +1,345 @@
+#include "hal.h"
+
+#if !AXES_ECHO_SIM
+
+#include <driver/gpio.h>
+#include <esp_freertos_hooks.h>
+#include <esp_sleep.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstring>
+
+namespace hal {
+
+DisplayPort Display;
+MicPort Mic;
+SpeakerPort Speaker;
+ImuPort Imu;
+PowerPort Power;
+ButtonPort BtnA(0);
+ButtonPort BtnB(1);
+
+static uint32_t gI2cTransactions = 0;
+static uint32_t gButtonEdgeUs[2] = {0, 0};
+
+// KEY1 / KEY2 (active low). Light sleep also wakes on either, so a press ends the sleep at
+// once instead of waiting for the next timer poll.
+static constexpr gpio_num_t kKeyPins[2] = {GPIO_NUM_11, GPIO_NUM_12};
+
+// Idle accounting. Where FreeRTOS run-time stats are compiled in, each core's IDLE task run-time
+// counter is used: the counters are 32-bit and clocked by portGET_RUN_TIME_COUNTER_VALUE, so
+// each read converts the delta to microseconds against the total run time and widens it to
+// 64 bits. Light sleep is charged to the task that entered it, so it is added back as idle for
+// that core only.
+//
+// The stock Arduino sdkconfig has no run-time stats, so the default is a per-core idle hook
+// that returns false: ESP-IDF then calls it back to back while the core idles (instead of
+// WAITI), and a gap between two calls shorter than kIdleGapMaxCycles is idle-loop time. Longer
+// gaps mean the IDLE task was preempted or an interrupt ran, and count as busy. The cycle sums
+// are 32-bit per core (one writer each) and are widened by cpuIdleUs(), which must run at least
+// every ~17 s at 240 MHz (telemetry reads every 5 s). Both cores stop in light sleep, so it
+// counts as idle for each of them.
+static constexpr uint8_t kMaxCores = 2;
+static uint64_t gLightSleepUs[kMaxCores] = {0, 0};
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+struct IdleClock {
+  uint32_t idleRun = 0;
+  uint32_t totalRun = 0;
+  uint32_t us = 0;
+  uint64_t idleUs = 0;
+  bool seeded = false;
+};
+static IdleClock gIdleClock[kMaxCores];
+#else
+static constexpr uint32_t kIdleGapMaxCycles = 2000;
+static volatile uint32_t gIdleLastCycles[kMaxCores] = {0, 0};
+static volatile uint32_t gIdleCycles[kMaxCores] = {0, 0};
+static uint32_t gIdleCyclesSeen[kMaxCores] = {0, 0};
+static uint64_t gIdleCyclesTotal[kMaxCores] = {0, 0};
+static bool gIdleHooked = false;
+
+static inline void noteIdle(uint8_t core) {
+  const uint32_t now = ESP.getCycleCount();
+  const uint32_t gap = now - gIdleLastCycles[core];
+  gIdleLastCycles[core] = now;
+  if (gap < kIdleGapMaxCycles) {
+    gIdleCycles[core] += gap;
+  }
+}
+
+static bool idleHookCore0() {
+  noteIdle(0);
+  return false;
+}
+
+static bool idleHookCore1() {
+  noteIdle(1);
+  return false;
+}
+#endif
+
+#if configUSE_TRACE_FACILITY
+static constexpr size_t kMaxTasks = 24;
+static TaskStatus_t gTaskStatus[kMaxTasks];
+#endif
+
+static m5::Button_Class& button(uint8_t id) {
+  return (id == 0) ? M5.BtnA : M5.BtnB;
+}
+
+void begin() {
+  auto cfg = M5.config();
+  cfg.serial_baudrate = 115200;
+  cfg.internal_mic = true;
+  cfg.internal_spk = true;
+  M5.begin(cfg);
+
+  for (gpio_num_t pin : kKeyPins) {
+    (void)gpio_wakeup_enable(pin, GPIO_INTR_LOW_LEVEL);
+  }
+  (void)esp_sleep_enable_gpio_wakeup();
+
+#if !(configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS)
+  gIdleHooked = esp_register_freertos_idle_hook_for_cpu(idleHookCore0, 0) == ESP_OK;
+  if (cpuCoreCount() > 1) {
+    gIdleHooked = (esp_register_freertos_idle_hook_for_cpu(idleHookCore1, 1) == ESP_OK) && gIdleHooked;
+  }
+#endif
+}
+
+void update() {
+  M5.update();
+  const uint32_t now = ::micros();
+  for (uint8_t id = 0; id < 2; ++id) {
+    if (button(id).wasPressed() || button(id).wasReleased()) {
+      gButtonEdgeUs[id] = now;
+    }
+  }
+}
+
+uint32_t millis() {
+  return ::millis();
+}
+
+uint32_t micros() {
+  return ::micros();
+}
+
+void delay(uint32_t ms) {
+  ::delay(ms);
+}
+
+void sleepUntil(uint32_t deadlineMs, bool allowLightSleep) {
+  const int32_t remaining = (int32_t)(deadlineMs - ::millis());
+  if (remaining <= 0) {
+    return;
+  }
+  // Skip light sleep while a USB host is attached: it would drop the CDC serial link.
+  if (allowLightSleep && (uint32_t)remaining >= kLightSleepMinMs && !Serial) {
+    esp_sleep_enable_timer_wakeup((uint64_t)remaining * 1000ull);
+    const uint32_t t0 = ::micros();
+    esp_light_sleep_start();
+    gLightSleepUs[std::min<int>(xPortGetCoreID(), kMaxCores - 1)] += ::micros() - t0;
+    return;
+  }
+  ::delay((uint32_t)remaining);
+}
+
+uint32_t cycleCount() {
+  return ESP.getCycleCount();
+}
+
+uint32_t cpuFreqMHz() {
+  return ESP.getCpuFreqMHz();
+}
+
+void logf(const char* fmt, ...) {
+  char buf[256];
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  Serial.print(buf);
+}
+
+uint32_t i2cTransactions() {
+  return gI2cTransactions;
+}
+
+uint32_t freeHeap() {
+  return (uint32_t)ESP.getFreeHeap();
+}
+
+uint32_t freePsram() {
+  return (uint32_t)ESP.getFreePsram();
+}
+
+void* allocLarge(size_t bytes) {
+  void* p = ps_malloc(bytes);
+  if (!p) {
+    p = malloc(bytes);
+  }
+  return p;
+}
+
+uint32_t minFreeHeap() {
+  return (uint32_t)ESP.getMinFreeHeap();
+}
+
+uint32_t largestFreeHeapBlock() {
+  return (uint32_t)ESP.getMaxAllocHeap();
+}
+
+uint32_t minFreePsram() {
+  return (uint32_t)ESP.getMinFreePsram();
+}
+
+uint32_t largestFreePsramBlock() {
+  return (uint32_t)ESP.getMaxAllocPsram();
+}
+
+size_t taskStacks(TaskStackInfo* out, size_t cap) {
+  if (out == nullptr || cap == 0) {
+    return 0;
+  }
+#if configUSE_TRACE_FACILITY
+  // ESP-IDF stacks are byte-granular, so the high-water marks are already in bytes.
+  TaskStatus_t* status = gTaskStatus;
+  const size_t n = (size_t)uxTaskGetSystemState(status, kMaxTasks, nullptr);
+  std::sort(status, status + n, [](const TaskStatus_t& a, const TaskStatus_t& b) { return a.usStackHighWaterMark < b.usStackHighWaterMark; });
+  const size_t count = std::min(n, cap);
+  for (size_t i = 0; i < count; ++i) {
+    strncpy(out[i].name, status[i].pcTaskName, sizeof(out[i].name) - 1);
+    out[i].name[sizeof(out[i].name) - 1] = '\0';
+    out[i].minFreeBytes = (uint32_t)status[i].usStackHighWaterMark;
+  }
+  return count;
+#else
+  // Without the trace facility only the calling (loop) task can be inspected.
+  strncpy(out[0].name, pcTaskGetName(nullptr), sizeof(out[0].name) - 1);
+  out[0].name[sizeof(out[0].name) - 1] = '\0';
+  out[0].minFreeBytes = (uint32_t)uxTaskGetStackHighWaterMark(nullptr);
+  return 1;
+#endif
+}
+
+uint8_t cpuCoreCount() {
+  return (uint8_t)std::min<int>(portNUM_PROCESSORS, kMaxCores);
+}
+
+bool cpuIdleMeasured() {
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+  return true;
+#else
+  return gIdleHooked;
+#endif
+}
+
+uint64_t cpuIdleUs(uint8_t core) {
+  if (core >= cpuCoreCount()) {
+    return 0;
+  }
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+  IdleClock& clk = gIdleClock[core];
+  uint32_t totalRun = 0;
+  const size_t n = (size_t)uxTaskGetSystemState(gTaskStatus, kMaxTasks, &totalRun);
+  const uint32_t us = ::micros();
+  const TaskHandle_t idleTask = xTaskGetIdleTaskHandleForCPU(core);
+  for (size_t i = 0; i < n; ++i) {
+    if (gTaskStatus[i].xHandle != idleTask) {
+      continue;
+    }
+    const uint32_t idleRun = (uint32_t)gTaskStatus[i].ulRunTimeCounter;
+    const uint32_t dTotal = totalRun - clk.totalRun;
+    if (clk.seeded && dTotal > 0) {
+      const uint32_t dIdle = std::min(idleRun - clk.idleRun, dTotal);
+      clk.idleUs += ((uint64_t)dIdle * (uint32_t)(us - clk.us)) / dTotal;
+    }
+    clk.idleRun = idleRun;
+    clk.totalRun = totalRun;
+    clk.us = us;
+    clk.seeded = true;
+    break;
+  }
+  return clk.idleUs + gLightSleepUs[core];
+#else
+  const uint32_t cycles = gIdleCycles[core];
+  gIdleCyclesTotal[core] += cycles - gIdleCyclesSeen[core];
+  gIdleCyclesSeen[core] = cycles;
+  uint64_t sleptUs = 0;
+  for (uint8_t c = 0; c < kMaxCores; ++c) {
+    sleptUs += gLightSleepUs[c];
+  }
+  return gIdleCyclesTotal[core] / std::max<uint32_t>(1, cpuFreqMHz()) + sleptUs;
+#endif
+}
+
+int DisplayPort::width() const { return M5.Display.width(); }
+int DisplayPort::height() const { return M5.Display.height(); }
+void DisplayPort::setRotation(uint8_t rot) { M5.Display.setRotation(rot); }
+void DisplayPort::fillScreen(uint16_t color) { M5.Display.fillScreen(color); }
+
+void DisplayPort::pushFrame(lgfx::LGFX_Sprite& frame) {
+  M5.Display.startWrite();
+  frame.pushSprite(&M5.Display, 0, 0);
+  M5.Display.endWrite();
+}
+
+bool MicPort::isEnabled() const { return M5.Mic.isEnabled(); }
+bool MicPort::isRunning() const { return M5.Mic.isRunning(); }
+void MicPort::end() { M5.Mic.end(); }
+bool MicPort::record(int16_t* buf, size_t samples, uint32_t rateHz) { return M5.Mic.record(buf, samples, rateHz, false); }
+bool MicPort::isRecording() const { return M5.Mic.isRecording() != 0; }
+
+bool SpeakerPort::isEnabled() const { return M5.Speaker.isEnabled(); }
+bool SpeakerPort::isRunning() const { return M5.Speaker.isRunning(); }
+bool SpeakerPort::begin() { return M5.Speaker.begin(); }
+void SpeakerPort::stop() { M5.Speaker.stop(); }
+void SpeakerPort::end() { M5.Speaker.end(); }
+void SpeakerPort::setVolume(uint8_t volume) { M5.Speaker.setVolume(volume); }
+bool SpeakerPort::tone(float hz, uint32_t ms) { return M5.Speaker.tone(hz, ms); }
+
+bool SpeakerPort::playRaw(const int16_t* buf, size_t samples, uint32_t rateHz, uint8_t channel) {
+  return M5.Speaker.playRaw(buf, samples, rateHz, false, 1, channel, false);
+}
+
+size_t SpeakerPort::isPlaying() const { return M5.Speaker.isPlaying(); }
+size_t SpeakerPort::isPlaying(uint8_t channel) const { return M5.Speaker.isPlaying(channel); }
+
+bool ImuPort::isEnabled() const { return M5.Imu.isEnabled(); }
+bool ImuPort::update() {
+  ++gI2cTransactions;
+  return M5.Imu.update();
+}
+
+bool ImuPort::getAccel(float* ax, float* ay, float* az) { return M5.Imu.getAccel(ax, ay, az); }
+
+int32_t PowerPort::getBatteryLevel() {
+  ++gI2cTransactions;
+  return M5.Power.getBatteryLevel();
+}
+
+int16_t PowerPort::getBatteryVoltage() {
+  ++gI2cTransactions;
+  return M5.Power.getBatteryVoltage();
+}
+
+bool PowerPort::isCharging() {
+  ++gI2cTransactions;
+  return M5.Power.isCharging() == m5::Power_Class::is_charging;
+}
+
+bool ButtonPort::isPressed() const { return button(id_).isPressed(); }
+bool ButtonPort::wasPressed() const { return button(id_).wasPressed(); }
+bool ButtonPort::wasReleased() const { return button(id_).wasReleased(); }
+bool ButtonPort::wasClicked() const { return button(id_).wasClicked(); }
+bool ButtonPort::pressedFor(uint32_t ms) const { return button(id_).pressedFor(ms); }
+uint32_t ButtonPort::edgeUs() const { return gButtonEdgeUs[id_]; }
+
+}  // namespace hal
+
+#endif
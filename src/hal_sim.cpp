@@ -0,0 +1,692 @@
+#include "hal.h"
+
+#if AXES_ECHO_SIM
+
+// Headless Linux backend: runs the real setup()/loop() against a simulated clock.
+//
+// Time only advances through hal::delay()/sleepUntil(), blocking speaker/display calls (cost
+// model) and a fixed per-loop charge, so runs are deterministic and typically much faster than
+// real time.
+// Inputs come from files; outputs are frame dumps, a raw speaker stream and a report.
+//
+//   program --duration-ms 20000 --mic mic.raw --imu imu.txt --buttons buttons.txt
+//           --frames out/ --dump-every 10 [--png] --spk-out spk.raw
+//
+//   mic.raw      int16 little-endian mono, consumed sequentially at the requested capture rate
+//   imu.txt      "t_ms ax ay az" per line (g units), sample-and-hold
+//   buttons.txt  "t_ms A|B down|up" per line
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+void setup();
+void loop();
+
+namespace hal {
+
+DisplayPort Display;
+MicPort Mic;
+SpeakerPort Speaker;
+ImuPort Imu;
+PowerPort Power;
+ButtonPort BtnA(0);
+ButtonPort BtnB(1);
+
+namespace {
+
+// StickS3 panel and the cost of one full-frame SPI push.
+constexpr int kPanelShort = 135;
+constexpr int kPanelLong = 240;
+constexpr uint32_t kButtonHoldMs = 500; // M5Unified default: release before this = click
+constexpr size_t kSpeakerChannels = 8;
+constexpr uint8_t kToneChannel = kSpeakerChannels - 1;
+
+// Memory model: allocLarge() draws from "PSRAM", everything else from the internal heap.
+// Large blocks are never returned (callers free() them directly), so PSRAM only shrinks.
+constexpr size_t kSimHeapBytes = 320u * 1024u;
+constexpr size_t kSimPsramBytes = 8u * 1024u * 1024u;
+constexpr size_t kSimLoopStackBytes = 8192; // Arduino loopTask default
+
+struct SimConfig {
+  uint32_t durationMs = 10000;
+  const char* micPath = nullptr;
+  const char* imuPath = nullptr;
+  const char* buttonsPath = nullptr;
+  const char* framesDir = nullptr;
+  const char* spkOutPath = nullptr;
+  uint32_t dumpEvery = 0;
+  bool png = false;
+  uint32_t spiHz = 40000000;
+  uint32_t loopCostUs = 50;
+};
+
+struct ImuSample {
+  uint32_t tMs;
+  float ax, ay, az;
+};
+
+struct ButtonEvent {
+  uint32_t tMs;
+  uint8_t id;
+  bool down;
+};
+
+struct ButtonSim {
+  bool pressed = false;
+  bool prev = false;
+  uint64_t pressStartUs = 0;
+  uint32_t edgeUs = 0;
+  bool wasPressed = false;
+  bool wasReleased = false;
+  bool wasClicked = false;
+};
+
+struct SpeakerChannel {
+  uint64_t endUs[2] = {0, 0};
+  size_t count = 0;
+};
+
+struct Stats {
+  uint64_t loops = 0;
+  uint64_t hostLoopNsSum = 0;
+  uint64_t hostLoopNsMax = 0;
+  uint64_t frames = 0;
+  uint64_t lastFrameUs = 0;
+  std::vector<uint32_t> frameIntervalsUs;
+  uint64_t micChunks = 0;
+  uint64_t micGapUsSum = 0;
+  uint64_t micGapUsMax = 0;
+  uint64_t powerReads = 0;
+  uint64_t i2cTransactions = 0;
+  uint64_t lightSleeps = 0;
+  uint64_t lightSleepUs = 0;
+  uint64_t codecConflicts = 0;
+  size_t heapHighWater = 0;
+  size_t largeAllocBytes = 0;
+  size_t heapUsedMax = 0; // internal heap only (excludes allocLarge)
+  uint64_t idleUs = 0;
+  size_t stackMaxBytes = 0;
+};
+
+SimConfig gCfg;
+Stats gStats;
+uint64_t gNowUs = 0;
+const char* gStackBase = nullptr; // a local in main(); loop() runs below it
+uint8_t gRotation = 0;
+
+FILE* gMicFile = nullptr;
+FILE* gSpkOut = nullptr;
+bool gMicRunning = false;
+bool gMicBusy = false;
+uint64_t gMicDoneUs = 0;
+uint64_t gMicLastDoneUs = 0;
+bool gMicHaveLast = false;
+
+bool gSpkRunning = false;
+SpeakerChannel gChannels[kSpeakerChannels];
+
+std::vector<ImuSample> gImu;
+size_t gImuIdx = 0;
+std::vector<ButtonEvent> gButtonScript;
+size_t gButtonIdx = 0;
+ButtonSim gButtons[2];
+
+void advanceSpeaker() {
+  for (SpeakerChannel& ch : gChannels) {
+    while (ch.count > 0 && ch.endUs[0] <= gNowUs) {
+      ch.endUs[0] = ch.endUs[1];
+      --ch.count;
+    }
+  }
+}
+
+void advanceMic() {
+  if (gMicBusy && gNowUs >= gMicDoneUs) {
+    gMicBusy = false;
+    gMicLastDoneUs = gMicDoneUs;
+    gMicHaveLast = true;
+  }
+}
+
+void advance(uint64_t us) {
+  gNowUs += us;
+  advanceSpeaker();
+  advanceMic();
+}
+
+// Host heap in use minus large blocks and the simulator's own bookkeeping.
+size_t simHeapUsed() {
+  const struct mallinfo2 mi = mallinfo2();
+  const size_t simOwn = gStats.frameIntervalsUs.capacity() * sizeof(uint32_t) + gImu.capacity() * sizeof(ImuSample) + gButtonScript.capacity() * sizeof(ButtonEvent);
+  const size_t used = (size_t)mi.uordblks + (size_t)mi.hblkhd;
+  return (used > gStats.largeAllocBytes + simOwn) ? used - gStats.largeAllocBytes - simOwn : 0;
+}
+
+void sampleHeap() {
+  const struct mallinfo2 mi = mallinfo2();
+  gStats.heapHighWater = std::max(gStats.heapHighWater, (size_t)mi.uordblks);
+  gStats.heapUsedMax = std::max(gStats.heapUsedMax, simHeapUsed());
+}
+
+// Host stack depth below main(), sampled at HAL entry points (host frames are close to, not
+// equal to, the Xtensa ones).
+void noteStack() {
+  const char here = 0;
+  if (gStackBase != nullptr && gStackBase > &here) {
+    gStats.stackMaxBytes = std::max(gStats.stackMaxBytes, (size_t)(gStackBase - &here));
+  }
+}
+
+bool loadImu(const char* path) {
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    return false;
+  }
+  ImuSample s;
+  while (fscanf(f, "%u %f %f %f", &s.tMs, &s.ax, &s.ay, &s.az) == 4) {
+    gImu.push_back(s);
+  }
+  fclose(f);
+  return true;
+}
+
+bool loadButtons(const char* path) {
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    return false;
+  }
+  unsigned t = 0;
+  char key[8];
+  char state[8];
+  while (fscanf(f, "%u %7s %7s", &t, key, state) == 3) {
+    ButtonEvent e;
+    e.tMs = t;
+    e.id = (key[0] == 'B' || key[0] == 'b') ? 1 : 0;
+    e.down = (strcmp(state, "down") == 0);
+    gButtonScript.push_back(e);
+  }
+  fclose(f);
+  std::stable_sort(gButtonScript.begin(), gButtonScript.end(), [](const ButtonEvent& a, const ButtonEvent& b) { return a.tMs < b.tMs; });
+  return true;
+}
+
+void dumpFrame(lgfx::LGFX_Sprite& frame) {
+  char path[512];
+  const int w = frame.width();
+  const int h = frame.height();
+  if (gCfg.png) {
+    snprintf(path, sizeof(path), "%s/frame_%06llu.png", gCfg.framesDir, (unsigned long long)gStats.frames);
+    size_t len = 0;
+    void* png = frame.createPng(&len, 0, 0, w, h);
+    FILE* f = png ? fopen(path, "wb") : nullptr;
+    if (f) {
+      fwrite(png, 1, len, f);
+      fclose(f);
+    }
+    free(png);
+    return;
+  }
+
+  snprintf(path, sizeof(path), "%s/frame_%06llu.ppm", gCfg.framesDir, (unsigned long long)gStats.frames);
+  FILE* f = fopen(path, "wb");
+  if (!f) {
+    return;
+  }
+  fprintf(f, "P6\n%d %d\n255\n", w, h);
+  std::vector<uint8_t> row((size_t)w * 3);
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      const uint16_t c = frame.readPixel(x, y);
+      row[(size_t)x * 3 + 0] = (uint8_t)(((c >> 11) & 0x1F) * 255 / 31);
+      row[(size_t)x * 3 + 1] = (uint8_t)(((c >> 5) & 0x3F) * 255 / 63);
+      row[(size_t)x * 3 + 2] = (uint8_t)((c & 0x1F) * 255 / 31);
+    }
+    fwrite(row.data(), 1, row.size(), f);
+  }
+  fclose(f);
+}
+
+uint32_t percentile(std::vector<uint32_t> v, int pct) {
+  if (v.empty()) {
+    return 0;
+  }
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (v.size() * (size_t)pct) / 100)];
+}
+
+void printReport(double hostSec) {
+  const double simSec = (double)gNowUs / 1e6;
+  printf("\n[sim] ---- report ----\n");
+  printf("[sim] simulated %.3f s in %.3f s host (%.1fx real time), %llu loops\n", simSec, hostSec, hostSec > 0 ? simSec / hostSec : 0.0, (unsigned long long)gStats.loops);
+  printf("[sim] loop host cost: avg %.1f us  max %.1f us\n", gStats.loops ? (double)gStats.hostLoopNsSum / (double)gStats.loops / 1000.0 : 0.0, (double)gStats.hostLoopNsMax / 1000.0);
+  printf("[sim] frames: %llu (%.1f fps)  interval p50 %u us  p95 %u us  max %u us\n", (unsigned long long)gStats.frames, simSec > 0 ? (double)gStats.frames / simSec : 0.0,
+         (unsigned)percentile(gStats.frameIntervalsUs, 50), (unsigned)percentile(gStats.frameIntervalsUs, 95), (unsigned)percentile(gStats.frameIntervalsUs, 100));
+  printf("[sim] mic: %llu chunks  capture gap avg %.1f us  max %llu us\n", (unsigned long long)gStats.micChunks, gStats.micChunks > 1 ? (double)gStats.micGapUsSum / (double)(gStats.micChunks - 1) : 0.0, (unsigned long long)gStats.micGapUsMax);
+  printf("[sim] i2c: %llu transactions (%.1f /s), power reads %llu (%.1f /s)\n", (unsigned long long)gStats.i2cTransactions, simSec > 0 ? (double)gStats.i2cTransactions / simSec : 0.0,
+         (unsigned long long)gStats.powerReads, simSec > 0 ? (double)gStats.powerReads / simSec : 0.0);
+  printf("[sim] light sleep: %llu entries  %.1f%% of time\n", (unsigned long long)gStats.lightSleeps, simSec > 0 ? 100.0 * (double)gStats.lightSleepUs / (double)gNowUs : 0.0);
+  printf("[sim] codec conflicts (mic+speaker both running): %llu\n", (unsigned long long)gStats.codecConflicts);
+  printf("[sim] heap high-water %zu bytes  large allocs %zu bytes  loop stack max %zu bytes\n", gStats.heapHighWater, gStats.largeAllocBytes, gStats.stackMaxBytes);
+}
+
+bool parseArgs(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+    if (strcmp(a, "--png") == 0) {
+      gCfg.png = true;
+      continue;
+    }
+    if (v == nullptr) {
+      fprintf(stderr, "missing value for %s\n", a);
+      return false;
+    }
+    ++i;
+    if (strcmp(a, "--duration-ms") == 0) gCfg.durationMs = (uint32_t)strtoul(v, nullptr, 10);
+    else if (strcmp(a, "--mic") == 0) gCfg.micPath = v;
+    else if (strcmp(a, "--imu") == 0) gCfg.imuPath = v;
+    else if (strcmp(a, "--buttons") == 0) gCfg.buttonsPath = v;
+    else if (strcmp(a, "--frames") == 0) gCfg.framesDir = v;
+    else if (strcmp(a, "--dump-every") == 0) gCfg.dumpEvery = (uint32_t)strtoul(v, nullptr, 10);
+    else if (strcmp(a, "--spk-out") == 0) gCfg.spkOutPath = v;
+    else if (strcmp(a, "--spi-hz") == 0) gCfg.spiHz = (uint32_t)strtoul(v, nullptr, 10);
+    else if (strcmp(a, "--loop-cost-us") == 0) gCfg.loopCostUs = (uint32_t)strtoul(v, nullptr, 10);
+    else {
+      fprintf(stderr, "unknown option %s\n", a);
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+void begin() {
+  if (gCfg.micPath != nullptr && (gMicFile = fopen(gCfg.micPath, "rb")) == nullptr) {
+    fprintf(stderr, "[sim] cannot open mic trace %s\n", gCfg.micPath);
+  }
+  if (gCfg.imuPath != nullptr && !loadImu(gCfg.imuPath)) {
+    fprintf(stderr, "[sim] cannot open imu trace %s\n", gCfg.imuPath);
+  }
+  if (gCfg.buttonsPath != nullptr && !loadButtons(gCfg.buttonsPath)) {
+    fprintf(stderr, "[sim] cannot open button script %s\n", gCfg.buttonsPath);
+  }
+  if (gCfg.spkOutPath != nullptr) {
+    gSpkOut = fopen(gCfg.spkOutPath, "wb");
+  }
+}
+
+void update() {
+  noteStack();
+  const uint64_t nowMs = gNowUs / 1000;
+  while (gButtonIdx < gButtonScript.size() && gButtonScript[gButtonIdx].tMs <= nowMs) {
+    gButtons[gButtonScript[gButtonIdx].id].pressed = gButtonScript[gButtonIdx].down;
+    ++gButtonIdx;
+  }
+  for (ButtonSim& b : gButtons) {
+    b.wasPressed = !b.prev && b.pressed;
+    b.wasReleased = b.prev && !b.pressed;
+    if (b.wasPressed) {
+      b.pressStartUs = gNowUs;
+    }
+    if (b.wasPressed || b.wasReleased) {
+      b.edgeUs = (uint32_t)gNowUs;
+    }
+    b.wasClicked = b.wasReleased && (gNowUs - b.pressStartUs) < (uint64_t)kButtonHoldMs * 1000u;
+    b.prev = b.pressed;
+  }
+}
+
+uint32_t millis() {
+  return (uint32_t)(gNowUs / 1000u);
+}
+
+uint32_t micros() {
+  return (uint32_t)gNowUs;
+}
+
+void delay(uint32_t ms) {
+  noteStack();
+  gStats.idleUs += (uint64_t)ms * 1000u;
+  advance((uint64_t)ms * 1000u);
+}
+
+uint32_t i2cTransactions() {
+  return (uint32_t)gStats.i2cTransactions;
+}
+
+void sleepUntil(uint32_t deadlineMs, bool allowLightSleep) {
+  int32_t remaining = (int32_t)(deadlineMs - millis());
+  if (remaining <= 0) {
+    return;
+  }
+  if (allowLightSleep && (uint32_t)remaining >= kLightSleepMinMs) {
+    // GPIO wakeup: a scripted button edge ends the sleep early.
+    if (gButtonIdx < gButtonScript.size()) {
+      const int32_t toEdge = (int32_t)(gButtonScript[gButtonIdx].tMs - millis());
+      remaining = std::min(remaining, toEdge);
+      if (remaining <= 0) {
+        return;
+      }
+    }
+    ++gStats.lightSleeps;
+    gStats.lightSleepUs += (uint64_t)remaining * 1000u;
+  }
+  gStats.idleUs += (uint64_t)remaining * 1000u;
+  advance((uint64_t)remaining * 1000u);
+}
+
+uint32_t cycleCount() {
+#if defined(__x86_64__) || defined(__i386__)
+  return (uint32_t)__builtin_ia32_rdtsc();
+#else
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+uint32_t cpuFreqMHz() {
+#if defined(__x86_64__) || defined(__i386__)
+  static uint32_t mhz = 0;
+  if (mhz == 0) {
+    const auto t0 = std::chrono::steady_clock::now();
+    const uint32_t c0 = cycleCount();
+    while (std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(20)) {
+    }
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    mhz = (uint32_t)((double)(cycleCount() - c0) / us);
+  }
+  return mhz;
+#else
+  return 1000;
+#endif
+}
+
+void logf(const char* fmt, ...) {
+  noteStack();
+  va_list ap;
+  va_start(ap, fmt);
+  vprintf(fmt, ap);
+  va_end(ap);
+}
+
+uint32_t freeHeap() {
+  const size_t used = simHeapUsed();
+  gStats.heapUsedMax = std::max(gStats.heapUsedMax, used);
+  return (uint32_t)((used < kSimHeapBytes) ? kSimHeapBytes - used : 0);
+}
+
+uint32_t freePsram() {
+  return (uint32_t)((gStats.largeAllocBytes < kSimPsramBytes) ? kSimPsramBytes - gStats.largeAllocBytes : 0);
+}
+
+uint32_t minFreeHeap() {
+  return (uint32_t)((gStats.heapUsedMax < kSimHeapBytes) ? kSimHeapBytes - gStats.heapUsedMax : 0);
+}
+
+// No fragmentation model: the whole free amount is one block.
+uint32_t largestFreeHeapBlock() {
+  return freeHeap();
+}
+
+uint32_t minFreePsram() {
+  return freePsram();
+}
+
+uint32_t largestFreePsramBlock() {
+  return freePsram();
+}
+
+size_t taskStacks(TaskStackInfo* out, size_t cap) {
+  if (out == nullptr || cap == 0) {
+    return 0;
+  }
+  snprintf(out[0].name, sizeof(out[0].name), "loopTask");
+  out[0].minFreeBytes = (uint32_t)((gStats.stackMaxBytes < kSimLoopStackBytes) ? kSimLoopStackBytes - gStats.stackMaxBytes : 0);
+  return 1;
+}
+
+uint8_t cpuCoreCount() {
+  return 1;
+}
+
+bool cpuIdleMeasured() {
+  return true;
+}
+
+uint64_t cpuIdleUs(uint8_t core) {
+  return (core == 0) ? gStats.idleUs : 0;
+}
+
+void* allocLarge(size_t bytes) {
+  void* p = malloc(bytes);
+  if (p) {
+    gStats.largeAllocBytes += bytes;
+  }
+  return p;
+}
+
+int DisplayPort::width() const { return (gRotation & 1) ? kPanelLong : kPanelShort; }
+int DisplayPort::height() const { return (gRotation & 1) ? kPanelShort : kPanelLong; }
+void DisplayPort::setRotation(uint8_t rot) { gRotation = rot; }
+void DisplayPort::fillScreen(uint16_t color) { (void)color; }
+
+void DisplayPort::pushFrame(lgfx::LGFX_Sprite& frame) {
+  noteStack();
+  const uint64_t bytes = (uint64_t)frame.width() * (uint64_t)frame.height() * 2u;
+  advance((bytes * 8u * 1000000u) / gCfg.spiHz);
+
+  if (gStats.frames > 0) {
+    gStats.frameIntervalsUs.push_back((uint32_t)(gNowUs - gStats.lastFrameUs));
+  }
+  gStats.lastFrameUs = gNowUs;
+  if (gCfg.framesDir != nullptr && gCfg.dumpEvery > 0 && (gStats.frames % gCfg.dumpEvery) == 0) {
+    dumpFrame(frame);
+  }
+  ++gStats.frames;
+}
+
+bool MicPort::isEnabled() const { return true; }
+bool MicPort::isRunning() const { return gMicRunning; }
+
+void MicPort::end() {
+  gMicRunning = false;
+  gMicBusy = false;
+  gMicHaveLast = false;
+}
+
+bool MicPort::record(int16_t* buf, size_t samples, uint32_t rateHz) {
+  if (buf == nullptr || samples == 0 || rateHz == 0 || gMicBusy) {
+    return false;
+  }
+  if (gSpkRunning) {
+    ++gStats.codecConflicts;
+  }
+  // Samples that arrived while no buffer was queued are lost on the real I2S path.
+  if (gMicHaveLast) {
+    const uint64_t gap = gNowUs - gMicLastDoneUs;
+    gStats.micGapUsSum += gap;
+    gStats.micGapUsMax = std::max(gStats.micGapUsMax, gap);
+  }
+  ++gStats.micChunks;
+
+  size_t got = gMicFile ? fread(buf, sizeof(int16_t), samples, gMicFile) : 0;
+  for (; got < samples; ++got) {
+    buf[got] = 0;
+  }
+  gMicRunning = true;
+  gMicBusy = true;
+  gMicDoneUs = gNowUs + ((uint64_t)samples * 1000000u) / rateHz;
+  return true;
+}
+
+bool MicPort::isRecording() const {
+  advanceMic();
+  return gMicBusy;
+}
+
+bool SpeakerPort::isEnabled() const { return true; }
+bool SpeakerPort::isRunning() const { return gSpkRunning; }
+
+bool SpeakerPort::begin() {
+  if (gMicRunning) {
+    ++gStats.codecConflicts;
+  }
+  gSpkRunning = true;
+  return true;
+}
+
+void SpeakerPort::stop() {
+  for (SpeakerChannel& ch : gChannels) {
+    ch.count = 0;
+  }
+}
+
+void SpeakerPort::end() {
+  stop();
+  gSpkRunning = false;
+}
+
+void SpeakerPort::setVolume(uint8_t volume) { (void)volume; }
+
+static bool enqueue(uint8_t channel, uint64_t durationUs) {
+  if (!gSpkRunning || channel >= kSpeakerChannels) {
+    return false;
+  }
+  advanceSpeaker();
+  SpeakerChannel& ch = gChannels[channel];
+  if (ch.count == 2) {
+    // M5Unified blocks until a slot frees; so does simulated time.
+    advance(ch.endUs[0] - gNowUs);
+  }
+  const uint64_t start = (ch.count > 0) ? ch.endUs[ch.count - 1] : gNowUs;
+  ch.endUs[ch.count++] = start + durationUs;
+  return true;
+}
+
+bool SpeakerPort::tone(float hz, uint32_t ms) {
+  (void)hz;
+  gChannels[kToneChannel].count = 0;
+  return enqueue(kToneChannel, (uint64_t)ms * 1000u);
+}
+
+bool SpeakerPort::playRaw(const int16_t* buf, size_t samples, uint32_t rateHz, uint8_t channel) {
+  if (buf == nullptr || samples == 0 || rateHz == 0) {
+    return false;
+  }
+  if (!enqueue(channel, ((uint64_t)samples * 1000000u) / rateHz)) {
+    return false;
+  }
+  if (gSpkOut != nullptr) {
+    fwrite(buf, sizeof(int16_t), samples, gSpkOut);
+  }
+  return true;
+}
+
+size_t SpeakerPort::isPlaying() const {
+  advanceSpeaker();
+  for (const SpeakerChannel& ch : gChannels) {
+    if (ch.count > 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+size_t SpeakerPort::isPlaying(uint8_t channel) const {
+  advanceSpeaker();
+  return (channel < kSpeakerChannels) ? gChannels[channel].count : 0;
+}
+
+bool ImuPort::isEnabled() const { return true; }
+bool ImuPort::update() {
+  ++gStats.i2cTransactions;
+  return true;
+}
+
+bool ImuPort::getAccel(float* ax, float* ay, float* az) {
+  const uint32_t nowMs = millis();
+  while (gImuIdx + 1 < gImu.size() && gImu[gImuIdx + 1].tMs <= nowMs) {
+    ++gImuIdx;
+  }
+  if (gImu.empty()) {
+    *ax = 0.0f;
+    *ay = 0.0f;
+    *az = 1.0f;
+  } else {
+    *ax = gImu[gImuIdx].ax;
+    *ay = gImu[gImuIdx].ay;
+    *az = gImu[gImuIdx].az;
+  }
+  return true;
+}
+
+int32_t PowerPort::getBatteryLevel() {
+  ++gStats.powerReads;
+  ++gStats.i2cTransactions;
+  return 87;
+}
+
+int16_t PowerPort::getBatteryVoltage() {
+  ++gStats.powerReads;
+  ++gStats.i2cTransactions;
+  return 4012;
+}
+
+bool PowerPort::isCharging() {
+  ++gStats.powerReads;
+  ++gStats.i2cTransactions;
+  return false;
+}
+
+bool ButtonPort::isPressed() const { return gButtons[id_].pressed; }
+bool ButtonPort::wasPressed() const { return gButtons[id_].wasPressed; }
+bool ButtonPort::wasReleased() const { return gButtons[id_].wasReleased; }
+bool ButtonPort::wasClicked() const { return gButtons[id_].wasClicked; }
+uint32_t ButtonPort::edgeUs() const { return gButtons[id_].edgeUs; }
+
+bool ButtonPort::pressedFor(uint32_t ms) const {
+  return gButtons[id_].pressed && (gNowUs - gButtons[id_].pressStartUs) >= (uint64_t)ms * 1000u;
+}
+
+}  // namespace hal
+
+int main(int argc, char** argv) {
+  if (!hal::parseArgs(argc, argv)) {
+    return 2;
+  }
+
+  const auto hostStart = std::chrono::steady_clock::now();
+  const char stackBase = 0;
+  hal::gStackBase = &stackBase;
+  setup();
+  const uint64_t endUs = (uint64_t)hal::gCfg.durationMs * 1000u;
+  while (hal::gNowUs < endUs) {
+    const auto t0 = std::chrono::steady_clock::now();
+    loop();
+    const uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+    hal::gStats.loops++;
+    hal::gStats.hostLoopNsSum += ns;
+    hal::gStats.hostLoopNsMax = std::max(hal::gStats.hostLoopNsMax, ns);
+    hal::advance(hal::gCfg.loopCostUs);
+    hal::sampleHeap();
+  }
+  const double hostSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - hostStart).count();
+  hal::printReport(hostSec);
+  if (hal::gSpkOut != nullptr) {
+    fclose(hal::gSpkOut);
+  }
+  if (hal::gMicFile != nullptr) {
+    fclose(hal::gMicFile);
+  }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,171 @@
+#include "latency_trace.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+using Stage = LatencyTrace::Stage;
+using Path = LatencyTrace::Path;
+
+constexpr uint16_t bit(Stage s) {
+  return (uint16_t)(1u << (uint8_t)s);
+}
+
+// Stages each path waits for; its kEnd stage closes it.
+constexpr uint16_t kPathStages[(size_t)Path::Count] = {
+  bit(Stage::SpeakerOff) | bit(Stage::MicRecord) | bit(Stage::FirstCapture),
+  bit(Stage::MicOff) | bit(Stage::SpeakerOn) | bit(Stage::PlayRaw) | bit(Stage::FirstPlayed),
+  bit(Stage::RenderStart) | bit(Stage::PushDone),
+};
+constexpr Stage kEnd[(size_t)Path::Count] = {Stage::FirstCapture, Stage::FirstPlayed, Stage::PushDone};
+
+constexpr uint32_t kBucketMs[LatencyTrace::kBuckets] = {5, 10, 20, 50, 100, 200, 500, 1000, 2000, UINT32_MAX};
+
+const char* const kPathNames[(size_t)Path::Count] = {"rec-start", "play-start", "bg-color"};
+const char* const kStageNames[(size_t)Stage::Count] = {"edge", "cancel", "spk-off", "spk-on", "mic-off", "mic-rec", "first-sample", "play-raw", "first-played", "render", "push"};
+
+}  // namespace
+
+void LatencyTrace::mark(Stage stage, uint32_t us, Path path) {
+  const uint32_t idx = head_.fetch_add(1, std::memory_order_relaxed);
+  Event& e = ring_[idx & (kRingSize - 1)];
+  // Seqlock: the slot reads as unwritten while its payload changes, so a reader that already
+  // saw the old seq fails its re-check instead of taking a torn event.
+  e.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  e.us.store(us, std::memory_order_relaxed);
+  e.stage.store((uint8_t)stage, std::memory_order_relaxed);
+  e.path.store((uint8_t)path, std::memory_order_relaxed);
+  e.seq.store(idx + 1, std::memory_order_release);
+}
+
+size_t LatencyTrace::collect() {
+  size_t n = 0;
+  for (;;) {
+    const Event& e = ring_[tail_ & (kRingSize - 1)];
+    const uint32_t seq = e.seq.load(std::memory_order_acquire);
+    if (seq != tail_ + 1) {
+      if ((int32_t)(seq - (tail_ + 1)) <= 0) {
+        break; // not written yet
+      }
+      // Lapped by writers: resume at the oldest event still in the ring.
+      const uint32_t oldest = head_.load(std::memory_order_acquire) - (uint32_t)kRingSize;
+      dropped_ += oldest - tail_;
+      tail_ = oldest;
+      continue;
+    }
+    const uint32_t us = e.us.load(std::memory_order_relaxed);
+    const Stage stage = (Stage)e.stage.load(std::memory_order_relaxed);
+    const Path path = (Path)e.path.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (e.seq.load(std::memory_order_relaxed) != seq) {
+      continue; // overwritten while reading; the next pass sees the lap
+    }
+    ++tail_;
+    ++n;
+    apply(us, stage, path);
+  }
+  return n;
+}
+
+void LatencyTrace::apply(uint32_t us, Stage stage, Path path) {
+  if (stage == Stage::ButtonEdge || stage == Stage::Cancel) {
+    if (path < Path::Count) {
+      Open& o = open_[(size_t)path];
+      o = Open();
+      o.active = (stage == Stage::ButtonEdge);
+      o.edgeUs = us;
+    }
+    return;
+  }
+  if (stage >= Stage::Count) {
+    return;
+  }
+  for (size_t p = 0; p < (size_t)Path::Count; ++p) {
+    Open& o = open_[p];
+    if (!o.active || (path != Path::Count && (size_t)path != p) || (kPathStages[p] & bit(stage)) == 0) {
+      continue;
+    }
+    const uint32_t offset = us - o.edgeUs;
+    if ((int32_t)offset < 0) {
+      continue; // stage from before the edge (marks are not strictly time-ordered across tasks)
+    }
+    if (offset > kPathTimeoutUs) {
+      o.active = false; // abandoned (e.g. mic failure); never completes
+      continue;
+    }
+    if ((o.stageMask & bit(stage)) == 0) {
+      o.stageMask |= bit(stage);
+      o.stageUs[(size_t)stage] = offset;
+    }
+    if (stage == kEnd[p]) {
+      finish((Path)p, offset);
+    }
+  }
+}
+
+void LatencyTrace::finish(Path path, uint32_t totalUs) {
+  Open& o = open_[(size_t)path];
+  PathStats& s = stats_[(size_t)path];
+  ++s.count;
+  s.maxUs = std::max(s.maxUs, totalUs);
+  s.sumUs += totalUs;
+  const uint32_t ms = totalUs / 1000u;
+  size_t b = 0;
+  while (ms >= kBucketMs[b] && b + 1 < kBuckets) {
+    ++b;
+  }
+  ++s.buckets[b];
+  std::copy(o.stageUs, o.stageUs + (size_t)Stage::Count, s.lastStageUs);
+  s.lastStageMask = o.stageMask;
+  o.active = false;
+}
+
+size_t LatencyTrace::format(Path path, char* out, size_t len) const {
+  if (out == nullptr || len == 0) {
+    return 0;
+  }
+  out[0] = '\0';
+  if (path >= Path::Count || stats_[(size_t)path].count == 0) {
+    return 0;
+  }
+  const PathStats& s = stats_[(size_t)path];
+
+  // Percentiles resolve to the upper edge of their histogram bucket.
+  char pct[2][12];
+  const uint32_t kPct[2] = {50, 90};
+  for (size_t i = 0; i < 2; ++i) {
+    const uint32_t rank = (s.count * kPct[i] + 99) / 100;
+    uint32_t seen = 0;
+    size_t b = 0;
+    while (b + 1 < kBuckets && (seen += s.buckets[b]) < rank) {
+      ++b;
+    }
+    if (b + 1 < kBuckets) {
+      snprintf(pct[i], sizeof(pct[i]), "<%lu", (unsigned long)kBucketMs[b]);
+    } else {
+      snprintf(pct[i], sizeof(pct[i]), ">=%lu", (unsigned long)kBucketMs[kBuckets - 2]);
+    }
+  }
+
+  const float avgMs = (float)s.sumUs / (1000.0f * (float)s.count);
+  int n = snprintf(out, len, "%s n=%lu avg %.1f p50 %s p90 %s max %.1f ms  hist", kPathNames[(size_t)path], (unsigned long)s.count, avgMs, pct[0], pct[1], (float)s.maxUs / 1000.0f);
+  for (size_t b = 0; b < kBuckets && n > 0 && (size_t)n < len; ++b) {
+    n += snprintf(out + n, len - (size_t)n, "%c%lu", (b == 0) ? ' ' : ',', (unsigned long)s.buckets[b]);
+  }
+
+  // Last completed trace, stages in time order.
+  Stage order[(size_t)Stage::Count];
+  size_t count = 0;
+  for (size_t st = 0; st < (size_t)Stage::Count; ++st) {
+    if ((s.lastStageMask & (1u << st)) != 0) {
+      order[count++] = (Stage)st;
+    }
+  }
+  std::stable_sort(order, order + count, [&](Stage a, Stage b) { return s.lastStageUs[(size_t)a] < s.lastStageUs[(size_t)b]; });
+  for (size_t i = 0; i < count && n > 0 && (size_t)n < len; ++i) {
+    n += snprintf(out + n, len - (size_t)n, "%s%s +%.1f", (i == 0) ? " | " : " ", kStageNames[(size_t)order[i]], (float)s.lastStageUs[(size_t)order[i]] / 1000.0f);
+  }
+  return (n > 0) ? std::min((size_t)n, len - 1) : 0;
+}
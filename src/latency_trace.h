@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Input-to-output latency tracing for the three paths users feel:
+//   rec-start : KEY2 press   -> first captured sample (after the denoiser delay when on)
+//   play-start: KEY2 release -> first clip sample on the speaker
+//   bg-color  : KEY1 click   -> frame with the new background pushed to the panel
+//
+// mark() is the only call on the hot paths: one atomic increment and a seqlocked 12-byte slot
+// store in a fixed ring, so it is wait-free, safe from any task, and cheap enough to stay on in
+// release builds (see the bench). collect() runs on the loop task only; it replays new ring events
+// into per-path stage timelines and latency histograms. Stages shared by several paths (speaker
+// and mic transitions, frame push) count for every path that is waiting for them.
+class LatencyTrace {
+ public:
+  enum class Path : uint8_t {
+    RecStart = 0,
+    PlayStart,
+    BgColor,
+    Count,
+  };
+
+  enum class Stage : uint8_t {
+    ButtonEdge = 0, // opens the event's path; `path` names which
+    Cancel,         // drops the event's open path (e.g. KEY2 released during the beep)
+    SpeakerOff,
+    SpeakerOn,
+    MicOff,
+    MicRecord,      // first Mic.record issued
+    FirstCapture,   // first sample of the first captured chunk
+    PlayRaw,        // first clip block handed to the speaker
+    FirstPlayed,    // that block starts sounding
+    RenderStart,
+    PushDone,
+    Count,
+  };
+
+  static constexpr size_t kRingSize = 64; // power of two
+  static constexpr size_t kBuckets = 10; // <5 <10 <20 <50 <100 <200 <500 <1000 <2000 >=2000 ms
+  static constexpr uint32_t kPathTimeoutUs = 5000000;
+
+  // Stage-only marks apply to every open path; Path::Count means "no specific path".
+  void mark(Stage stage, uint32_t us, Path path = Path::Count);
+
+  // Consumes new ring events; returns how many were processed.
+  size_t collect();
+
+  struct PathStats {
+    uint32_t count = 0;
+    uint32_t maxUs = 0;
+    uint64_t sumUs = 0;
+    uint32_t buckets[kBuckets] = {0};
+    uint32_t lastStageUs[(size_t)Stage::Count] = {0}; // offsets from the edge in the last completed trace
+    uint16_t lastStageMask = 0;
+  };
+  const PathStats& stats(Path path) const { return stats_[(size_t)path]; }
+  uint32_t dropped() const { return dropped_; }
+
+  // "<path> n=.. avg .. p50 <.. p90 <.. max .. ms  hist <counts per bucket> | <stage> +<ms> ..."
+  // with the stages of the last completed trace; empty if the path never completed.
+  size_t format(Path path, char* out, size_t len) const;
+
+ private:
+  struct Event {
+    std::atomic<uint32_t> seq{0}; // ring index + 1 once the slot is written, 0 while writing
+    std::atomic<uint32_t> us{0};
+    std::atomic<uint8_t> stage{0};
+    std::atomic<uint8_t> path{0};
+  };
+
+  struct Open {
+    bool active = false;
+    uint32_t edgeUs = 0;
+    uint32_t stageUs[(size_t)Stage::Count] = {0};
+    uint16_t stageMask = 0;
+  };
+
+  void apply(uint32_t us, Stage stage, Path path);
+  void finish(Path path, uint32_t endUs);
+
+  Event ring_[kRingSize];
+  std::atomic<uint32_t> head_{0};
+  uint32_t tail_ = 0;
+  uint32_t dropped_ = 0;
+  Open open_[(size_t)Path::Count];
+  PathStats stats_[(size_t)Path::Count];
+};
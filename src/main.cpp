@@ -1,8 +1,29 @@
-#include <Arduino.h>
-#include <M5Unified.h>
-
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <vector>
 
+#include "audio_path.h"
+#include "bench.h"
+#include "boot_profile.h"
+#include "clip_library.h"
+#include "codec.h"
+#include "conditioner.h"
+#include "denoise.h"
+#include "effects.h"
+#include "fft.h"
+#include "hal.h"
+#include "latency_trace.h"
+#include "mixer.h"
+#include "render_governor.h"
+#include "resampler.h"
+#include "sensor_service.h"
+#include "telemetry.h"
+#include "vad.h"
+#include "vector_scene.h"
+#include "waveform_pyramid.h"
+
 static constexpr uint16_t kBgPalette16[] = {
   TFT_BLACK,
   TFT_NAVY,
@@ -54,128 +75,152 @@ static bool imuOk = false;
 static constexpr uint8_t kPortraitRotation = 0;
 static constexpr uint8_t kStatusRotation = 1;
 
+// Axes screen pacing: adaptive frame rate, light sleep between wakeups while idle.
+static RenderGovernor gRenderGov;
+static bool gIdleLightSleep = true;
+
+// Battery/charge readings, polled off the render path; drawing only reads the cache.
+static SlowSensorService gSensors;
+
+// Axes screen: accelerometer tracks (raw / filtered / gravity) and the integer arrow renderer.
+static AccelTracks gAccel;
+static VectorScene gScene;
+
+// Clip library: every take is stored ADPCM-encoded in PSRAM; the recording buffer holds the
+// decoded working copy of one clip. KEY2 tap selects the next clip (0 = newest).
+static ClipLibrary gClips;
+static size_t gClipSel = 0;
+
+// Heap/PSRAM/stack/CPU snapshots for soak runs: logged as [tele], shown on the TELEMETRY page.
+static Telemetry gTelemetry;
+static bool gTelemetryDirty = false;
+
+// Wakeups / frames per second per loop mode, logged as [loop] once per window.
+static LoopRateStats gLoopStats;
+static uint8_t loopStatsMode();
+
+// Button-to-output latency per path (KEY2 -> mic / speaker, KEY1 -> panel), logged as [lat].
+static LatencyTrace gTrace;
+
+// Boot timeline; setup() only brings up what the first frame needs, the rest is deferred.
+static BootProfile gBoot;
+static bool gLandscapeReady = false;
+static bool stepDeferredInit();
+static void finishDeferredInit();
+
+static void presentFrame(lgfx::LGFX_Sprite& frame) {
+  gLoopStats.frame(loopStatsMode());
+  hal::Display.pushFrame(frame);
+  gTrace.mark(LatencyTrace::Stage::PushDone, hal::micros());
+}
+
 static void setDisplayRotation(uint8_t rot) {
   if (gDisplayRotation == rot) {
     return;
   }
   gDisplayRotation = rot;
-  M5.Display.setRotation(rot);
+  hal::Display.setRotation(rot);
 }
 
-static void drawArrow2D(lgfx::LGFX_Sprite& s, int x0, int y0, int x1, int y1, uint16_t color) {
-  s.drawLine(x0, y0, x1, y1, color);
-
-  const float dx = (float)(x1 - x0);
-  const float dy = (float)(y1 - y0);
-  const float len = sqrtf(dx * dx + dy * dy);
-  if (len < 6.0f) {
+// Landscape buffer for REC/PLAY UI, created on first use (or by the deferred boot steps).
+static void ensureLandscapeSprite() {
+  if (gLandscapeReady) {
     return;
   }
-
-  const float ux = dx / len;
-  const float uy = dy / len;
-  const float headLen = 10.0f;
-  const float headW = 6.0f;
-
-  const float bx = (float)x1 - ux * headLen;
-  const float by = (float)y1 - uy * headLen;
-
-  const float px = -uy;
-  const float py = ux;
-
-  const int lx = (int)lroundf(bx + px * headW);
-  const int ly = (int)lroundf(by + py * headW);
-  const int rx = (int)lroundf(bx - px * headW);
-  const int ry = (int)lroundf(by - py * headW);
-
-  s.fillTriangle(x1, y1, lx, ly, rx, ry, color);
+  // Panel dimensions swap with odd rotations; no rotation round-trip needed.
+  const bool landscapeNow = (gDisplayRotation & 1u) == (kStatusRotation & 1u);
+  const int w = landscapeNow ? hal::Display.width() : hal::Display.height();
+  const int h = landscapeNow ? hal::Display.height() : hal::Display.width();
+  frameSpriteLandscape.setColorDepth(16);
+  gLandscapeReady = frameSpriteLandscape.createSprite(w, h) != nullptr;
 }
 
-static void drawAxesScreen(float ax, float ay, float az) {
+static void drawAxesScreen() {
+  gTrace.mark(LatencyTrace::Stage::RenderStart, hal::micros());
   // Normal UI uses portrait.
   setDisplayRotation(kPortraitRotation);
 
   auto& s = frameSpritePortrait;
   s.fillScreen(bgColor);
 
-  const float norm = sqrtf(ax * ax + ay * ay + az * az);
-  const float inv = (norm > 1e-6f) ? (1.0f / norm) : 1.0f;
-  const float nx = ax * inv;
-  const float ny = ay * inv;
-  const float nz = az * inv;
-
-  const float angXY = atan2f(ay, ax) * (180.0f / PI);
-  const float angXZ = atan2f(az, ax) * (180.0f / PI);
-  const float angYZ = atan2f(az, ay) * (180.0f / PI);
-
-  // Pseudo-3D basis vectors on screen.
-  // X: right, Y: up, Z: down-right (gives a simple 3D feel).
-  const float bxX = 1.0f, byX = 0.0f;
-  const float bxY = 0.0f, byY = -1.0f;
-  const float bxZ = 0.70f, byZ = 0.70f;
-
-  auto map3 = [&](float x, float y, float z, float scale, float& outX, float& outY) {
-    outX = (x * bxX + y * bxY + z * bxZ) * scale;
-    outY = (x * byX + y * byY + z * byZ) * scale;
-  };
+  // Q12 g throughout; floats only where the readout is formatted.
+  const AccelTracks::Vec& a = gAccel.raw();
+  // |a|^2 >> 8 is |a| in Q8 squared: fits 32 bits up to 256 g, and r = 2^31 / |a|_Q8.
+  const uint32_t a2 = (uint32_t)(((int64_t)a.x * a.x + (int64_t)a.y * a.y + (int64_t)a.z * a.z) >> 8);
+  const uint32_t r = fastRsqrt(a2);
+  const int32_t norm = (int32_t)((((uint64_t)a2 * r) >> 31) << 4);
+  const int32_t nx = (a2 > 0) ? (int32_t)(((int64_t)a.x * r) >> 23) : a.x;
+  const int32_t ny = (a2 > 0) ? (int32_t)(((int64_t)a.y * r) >> 23) : a.y;
+  const int32_t nz = (a2 > 0) ? (int32_t)(((int64_t)a.z * r) >> 23) : a.z;
+
+  const int32_t angXY = fastAtan2Cdeg(a.y, a.x);
+  const int32_t angXZ = fastAtan2Cdeg(a.z, a.x);
+  const int32_t angYZ = fastAtan2Cdeg(a.z, a.y);
 
   const int cx = s.width() / 2;
   const int cy = s.height() / 2 + 10;
-  const float axisLen = (float)std::min<int>(s.width(), s.height()) * 0.28f;
+  const int axisLen = std::min<int>(s.width(), s.height()) * 28 / 100;
+  gScene.begin((uint16_t*)s.getBuffer(), s.width(), s.height(), cx, cy, axisLen);
+  constexpr int kSub = VectorScene::kSubBits;
 
   // Axes
-  float dx = 0.0f, dy = 0.0f;
-  map3(1, 0, 0, axisLen, dx, dy);
-  const int xEnd = cx + (int)lroundf(dx);
-  const int yEnd = cy + (int)lroundf(dy);
-  drawArrow2D(s, cx, cy, xEnd, yEnd, TFT_RED);
+  static constexpr int32_t kOneG = 4096;
+  const VectorScene::Point tipX = gScene.project(kOneG, 0, 0);
+  gScene.drawArrow(tipX, TFT_RED);
   s.setTextDatum(middle_left);
   s.setTextColor(TFT_RED, bgColor);
-  s.drawString("X", xEnd + 6, yEnd);
+  s.drawString("X", (tipX.x >> kSub) + 6, tipX.y >> kSub);
 
-  map3(0, 1, 0, axisLen, dx, dy);
-  const int xEndY = cx + (int)lroundf(dx);
-  const int yEndY = cy + (int)lroundf(dy);
-  drawArrow2D(s, cx, cy, xEndY, yEndY, TFT_GREEN);
+  const VectorScene::Point tipY = gScene.project(0, kOneG, 0);
+  gScene.drawArrow(tipY, TFT_GREEN);
   s.setTextColor(TFT_GREEN, bgColor);
-  s.drawString("Y", xEndY + 6, yEndY);
+  s.drawString("Y", (tipY.x >> kSub) + 6, tipY.y >> kSub);
 
-  map3(0, 0, 1, axisLen, dx, dy);
-  const int xEndZ = cx + (int)lroundf(dx);
-  const int yEndZ = cy + (int)lroundf(dy);
-  drawArrow2D(s, cx, cy, xEndZ, yEndZ, TFT_BLUE);
+  const VectorScene::Point tipZ = gScene.project(0, 0, kOneG);
+  gScene.drawArrow(tipZ, TFT_BLUE);
   s.setTextColor(TFT_BLUE, bgColor);
-  s.drawString("Z", xEndZ + 6, yEndZ);
-
-  // Acceleration vector (normalized), drawn in the same pseudo-3D basis.
-  map3(nx, ny, nz, axisLen, dx, dy);
-  const int xAcc = cx + (int)lroundf(dx);
-  const int yAcc = cy + (int)lroundf(dy);
-  drawArrow2D(s, cx, cy, xAcc, yAcc, TFT_YELLOW);
+  s.drawString("Z", (tipZ.x >> kSub) + 6, tipZ.y >> kSub);
+
+  // Gravity (slow low-pass), filtered and raw acceleration at their magnitude (1 g = one
+  // axis length, clamped at 1.5 g), raw on top.
+  static constexpr int32_t kMaxDrawQ12 = 6144;
+  const AccelTracks::Vec g = gAccel.gravity();
+  const AccelTracks::Vec f = gAccel.filtered();
+  gScene.drawArrow(gScene.projectClamped(g.x, g.y, g.z, kMaxDrawQ12), TFT_MAGENTA);
+  gScene.drawArrow(gScene.projectClamped(f.x, f.y, f.z, kMaxDrawQ12), TFT_CYAN);
+  const VectorScene::Point tipA = gScene.projectClamped(a.x, a.y, a.z, kMaxDrawQ12);
+  gScene.drawArrow(tipA, TFT_YELLOW);
   s.setTextColor(TFT_YELLOW, bgColor);
   s.setTextDatum(middle_center);
-  s.drawString("a", xAcc, yAcc - 10);
+  s.drawString("a", tipA.x >> kSub, (tipA.y >> kSub) - 10);
 
   // Text readout
   s.setTextDatum(top_left);
   s.setTextSize(1);
   s.setTextColor(TFT_WHITE, bgColor);
   char line[96];
-  snprintf(line, sizeof(line), "ax:% .3f  ay:% .3f  az:% .3f", ax, ay, az);
+  static constexpr float kQ12 = 1.0f / 4096.0f;
+  snprintf(line, sizeof(line), "ax:% .3f  ay:% .3f  az:% .3f", (float)a.x * kQ12, (float)a.y * kQ12, (float)a.z * kQ12);
   s.drawString(line, 6, 6);
-  snprintf(line, sizeof(line), "|a|:% .3f   nx:% .2f ny:% .2f nz:% .2f", norm, nx, ny, nz);
+  snprintf(line, sizeof(line), "|a|:% .3f   nx:% .2f ny:% .2f nz:% .2f", (float)norm * kQ12, (float)nx * kQ12, (float)ny * kQ12, (float)nz * kQ12);
   s.drawString(line, 6, 20);
-  snprintf(line, sizeof(line), "atan2(ay,ax):% .1f deg", angXY);
+  snprintf(line, sizeof(line), "atan2(ay,ax):% .1f deg", (float)angXY / 100.0f);
   s.drawString(line, 6, 34);
-  snprintf(line, sizeof(line), "atan2(az,ax):% .1f deg", angXZ);
+  snprintf(line, sizeof(line), "atan2(az,ax):% .1f deg", (float)angXZ / 100.0f);
   s.drawString(line, 6, 48);
-  snprintf(line, sizeof(line), "atan2(az,ay):% .1f deg", angYZ);
+  snprintf(line, sizeof(line), "atan2(az,ay):% .1f deg", (float)angYZ / 100.0f);
   s.drawString(line, 6, 62);
+  s.setTextColor(TFT_YELLOW, bgColor);
+  s.drawString("raw", 6, 76);
+  s.setTextColor(TFT_CYAN, bgColor);
+  s.drawString("filtered", 30, 76);
+  s.setTextColor(TFT_MAGENTA, bgColor);
+  s.drawString("gravity", 84, 76);
 
   s.setTextColor(TFT_LIGHTGREY, bgColor);
 
   // Status row: uptime (left) + battery (right).
-  const uint32_t upSec = millis() / 1000u;
+  const uint32_t upSec = hal::millis() / 1000u;
   const uint32_t upMin = upSec / 60u;
   const uint32_t upHr = upMin / 60u;
   const uint32_t upDispMin = upMin % 60u;
@@ -183,46 +228,92 @@ static void drawAxesScreen(float ax, float ay, float az) {
   char upLine[32];
   snprintf(upLine, sizeof(upLine), "up %lu:%02lu:%02lu", (unsigned long)upHr, (unsigned long)upDispMin, (unsigned long)upDispSec);
 
-  int batt = (int)M5.Power.getBatteryLevel();
-  const int16_t battMv = M5.Power.getBatteryVoltage();
   char battLine[24];
-  if (batt < 0 || battMv <= 0) {
+  if (!gSensors.batteryValid()) {
     snprintf(battLine, sizeof(battLine), "bat --%%");
   } else {
-    if (batt > 100) batt = 100;
-    if (batt < 0) batt = 0;
-    snprintf(battLine, sizeof(battLine), "bat %d%%", batt);
+    snprintf(battLine, sizeof(battLine), "bat %d%%%s", gSensors.batteryLevel(), gSensors.charging() ? "+" : "");
+  }
+
+  char clipLine[48];
+  const ClipLibrary::ClipInfo* clip = gClips.at(gClipSel);
+  if (clip == nullptr) {
+    snprintf(clipLine, sizeof(clipLine), "no clips");
+  } else {
+    snprintf(clipLine, sizeof(clipLine), "clip %u/%u  %.1fs  %.0f dBFS", (unsigned)(gClipSel + 1), (unsigned)gClips.count(), (float)clip->samples / (float)clip->rateHz, clip->rmsDbfs);
   }
 
   s.setTextDatum(top_left);
+  s.drawString(clipLine, 6, s.height() - 50);
   s.drawString(upLine, 6, s.height() - 38);
   s.setTextDatum(top_right);
   s.drawString(battLine, s.width() - 6, s.height() - 38);
 
   s.setTextDatum(top_left);
   s.drawString("KEY1: color   HOLD KEY1: PLAY", 6, s.height() - 26);
-  s.drawString("KEY2: hold rec / release play", 6, s.height() - 14);
+  s.drawString("KEY2: tap next clip / hold rec", 6, s.height() - 14);
 
-  M5.Display.startWrite();
-  s.pushSprite(&M5.Display, 0, 0);
-  M5.Display.endWrite();
+  presentFrame(s);
 }
 
-// --- Audio record/playback (KEY2 = M5.BtnB) ---
+// --- Audio record/playback (KEY2 = hal::BtnB) ---
+// Default capture rate; the buffer is sized for 30 s at this rate.
 static constexpr uint32_t kRecSampleRateHz = 16000;
 static constexpr size_t kRecChunkSamples = 512;
 static constexpr uint8_t kMasterVolume = static_cast<uint8_t>(255 * 0.70f);
 
+// Selectable capture rates. Lower rates trade bandwidth for longer takes in the same buffer.
+static constexpr uint32_t kRecRatesHz[] = {8000, 16000, 24000, 32000};
+static constexpr size_t kRecRateCount = sizeof(kRecRatesHz) / sizeof(kRecRatesHz[0]);
+static uint8_t gRecRateIndex = 1;
+static uint32_t gRecClipRateHz = kRecSampleRateHz; // rate of the take currently in gRecPcm
+
+// Playback speed (Q8: 256 = 1.0x). Pitch is either preserved (time-stretch) or follows speed (resample).
+static constexpr uint16_t kPlaySpeedsQ8[] = {128, 192, 256, 320, 384, 512};
+static constexpr size_t kPlaySpeedCount = sizeof(kPlaySpeedsQ8) / sizeof(kPlaySpeedsQ8[0]);
+static uint8_t gPlaySpeedIndex = 2;
+static bool gPlayKeepPitch = true;
+
+// Playback effects (pitch shift -> echo -> reverb) on the clip stream; delay lines in PSRAM.
+static EffectsChain gEffects;
+static uint8_t gEchoIndex = 0;
+static uint8_t gReverbIndex = 0;
+static uint8_t gPitchFxIndex = 0;
+static uint32_t gPlayTailLeft = 0; // silence still to feed through the effects after the clip
+
 // Recording buffer is sized at runtime (PSRAM/heap). These are the computed limits.
 static uint32_t gRecMaxMs = 3000;
 static size_t gRecMaxSamples = (kRecSampleRateHz * 3000) / 1000;
 
 static int16_t* gRecPcm = nullptr;
 static size_t gRecSamples = 0;
+static WaveformPyramid gRecWave; // min/max overview of gRecPcm, updated per chunk
+
+// Capture conditioning (DC block + AGC + limiter), applied in place to each chunk.
+static bool gRecCondition = true;
+static CaptureConditioner gRecConditioner;
+
+// Noise suppression (STFT Wiener gain), in place on each chunk ahead of conditioning.
+// The learned noise profile carries over to the next take at the same rate.
+static bool gRecDenoise = false; // opt-in: ~+4.5 dB SNR on fan noise, 32 ms more delay
+static RealFft gFft; // shared FFT tables, NoiseSuppressor::kFrame points
+static NoiseSuppressor gRecDenoiser;
+
+// Silence trimming: VAD on per-chunk metrics; dropped chunks never advance gRecSamples.
+static bool gRecTrimSilence = true;
+static VoiceActivityDetector gRecVad;
+static SilenceTrimmer gRecTrimmer;
+static size_t gRecOrigSamples = 0; // captured length before trimming
 static bool gRecReadyWaitRelease = false;
 static bool gRecActive = false;
-static std::vector<uint8_t> gRecAdpcm;
+static std::vector<uint8_t> gRecAdpcm; // encode/decode scratch for library clips
+static uint8_t gRecCodecIndex = 0; // into kCodecs; new takes are stored with it
+static uint32_t gLoadedClipId = 0; // library clip currently decoded into gRecPcm (0 = none)
+static constexpr uint32_t kClipArenaBytes = 2u * 1024u * 1024u;
 static bool gRecStartRequested = false;
+static bool gRecBeepPending = false; // beep queued; recording starts once it has drained
+static uint32_t gRecBeepDeadlineMs = 0;
+static constexpr uint16_t kRecBeepMs = 60;
 static bool gPlayActive = false;
 
 static constexpr size_t kRecSpectrumBins = 16;
@@ -242,78 +333,470 @@ enum class UiMode : uint8_t {
   HoldMaxRelease,
   Playing,
   Error,
+  Settings,
+  Telemetry,
 };
 
 static UiMode gUiMode = UiMode::Normal;
+
+// UI sounds and clip playback share one mixer on one speaker channel; pumpAudio() keeps the
+// queue topped up from loop(), so sounds overlap and nothing waits for the speaker.
+static AudioMixer gMixer;
+static constexpr uint8_t kAudioChannel = 0;
+static constexpr uint32_t kUiMixRateHz = 16000; // mixer rate when no clip is playing
+
+// Speaker/mic ownership of the shared codec; every switch goes through it.
+static AudioPath gAudio;
+
+// UiMode values, plus the axes screen split by governor tier.
+static constexpr uint8_t kLoopModeAxesIdle = 8;
+static const char* const kLoopModeNames[] = {"axes", "beep", "rec", "hold", "play", "error", "settings", "telemetry", "axes-idle"};
+
+static uint8_t loopStatsMode() {
+  if (gUiMode == UiMode::Normal && gRenderGov.tier() == RenderGovernor::Tier::Idle) {
+    return kLoopModeAxesIdle;
+  }
+  return (uint8_t)gUiMode;
+}
+
+static void logLoopStats() {
+  char line[192];
+  size_t len = 0;
+  for (uint8_t m = 0; m < sizeof(kLoopModeNames) / sizeof(kLoopModeNames[0]); ++m) {
+    if (gLoopStats.timeShare(m) <= 0.0f || len >= sizeof(line)) {
+      continue;
+    }
+    len += (size_t)snprintf(line + len, sizeof(line) - len, "  %s %.0f%% %.1f fps %.1f wake/s", kLoopModeNames[m], 100.0f * gLoopStats.timeShare(m), gLoopStats.framesPerSec(m), gLoopStats.wakesPerSec(m));
+  }
+  hal::logf("[loop]%s\n", (len > 0) ? line : " idle");
+
+  static uint32_t lastI2c = 0;
+  const uint32_t i2c = hal::i2cTransactions();
+  hal::logf("[i2c] %.1f transactions/s  (sensor reads since boot: level %lu  mV %lu  charge %lu)\n", (float)(i2c - lastI2c) * 1000.0f / (float)LoopRateStats::kWindowMs,
+            (unsigned long)gSensors.reads(SlowSensorService::Channel::BatteryLevel), (unsigned long)gSensors.reads(SlowSensorService::Channel::BatteryVoltage),
+            (unsigned long)gSensors.reads(SlowSensorService::Channel::ChargeState));
+  lastI2c = i2c;
+
+  // Cumulative since boot; a path is re-logged only when it gained samples.
+  static uint32_t loggedCount[(size_t)LatencyTrace::Path::Count] = {0};
+  for (size_t p = 0; p < (size_t)LatencyTrace::Path::Count; ++p) {
+    const LatencyTrace::Path path = (LatencyTrace::Path)p;
+    if (gTrace.stats(path).count == loggedCount[p]) {
+      continue;
+    }
+    loggedCount[p] = gTrace.stats(path).count;
+    char line[224];
+    (void)gTrace.format(path, line, sizeof(line));
+    hal::logf("[lat] %s\n", line);
+  }
+
+  // Codec switches since boot, re-logged when one happened.
+  static uint32_t loggedSwitches = 0;
+  const uint32_t switches = gAudio.stats(AudioPath::Transition::ToSpeaker).count + gAudio.stats(AudioPath::Transition::ToMic).count + gAudio.reverted();
+  if (switches != loggedSwitches) {
+    loggedSwitches = switches;
+    char codec[160];
+    (void)gAudio.format(codec, sizeof(codec));
+    hal::logf("[codec] %s\n", codec);
+  }
+
+  const AudioMixer::LatencyStats& lat = gMixer.latency();
+  if (lat.count > 0) {
+    hal::logf("[audio] %lu sounds  start latency avg %.1f ms  max %.1f ms  last %.1f ms\n", (unsigned long)lat.count, (float)lat.sumUs / (1000.0f * (float)lat.count), (float)lat.maxUs / 1000.0f, (float)lat.lastUs / 1000.0f);
+    gMixer.resetLatency();
+  }
+}
+
+// Sleeps until the governor's next deadline; light sleep only while the axes screen is idle.
+// While the mixer has voices the wait is capped so the speaker queue never runs dry.
+static void idleUntilNextFrame() {
+  static constexpr uint32_t kAudioPumpMs = 4;
+  // Deferred boot work takes the first idle gaps, one step each, instead of sleeping.
+  if (stepDeferredInit()) {
+    return;
+  }
+  if (gMixer.active()) {
+    const uint32_t pumpMs = hal::millis() + kAudioPumpMs;
+    hal::sleepUntil(((int32_t)(pumpMs - gRenderGov.nextWakeMs()) < 0) ? pumpMs : gRenderGov.nextWakeMs(), false);
+    return;
+  }
+  const bool lightSleep = gIdleLightSleep && gRenderGov.tier() == RenderGovernor::Tier::Idle && !hal::Speaker.isPlaying();
+  hal::sleepUntil(gRenderGov.nextWakeMs(), lightSleep);
+}
 static uint32_t gRecStartMs = 0;
 static uint32_t gUiLastDrawMs = 0;
 static const char* gLastError = nullptr;
 
-static void ensureSpeakerOn() {
-  if (!M5.Speaker.isEnabled()) {
-    return;
+static void updateRecLimits() {
+  gRecMaxMs = (uint32_t)((gRecMaxSamples * 1000ull) / kRecRatesHz[gRecRateIndex]);
+}
+
+// The mixer output streams in small blocks so speed/pitch processing runs on the fly.
+// The speaker channel holds one playing + one queued block; the third is being rendered.
+// UI-only sounds use short blocks so a tap is heard within ~2 blocks.
+static constexpr size_t kPlayBlockSamples = 1024; // 32 ms at 32 kHz: covers a status-screen redraw
+static constexpr size_t kUiBlockSamples = 256;    // 16 ms at the UI mix rate
+static constexpr size_t kAudioBlockCount = 3;
+static_assert(kPlayBlockSamples <= AudioMixer::kMaxBlockSamples, "Mixer block too small");
+
+enum class PlayPath : uint8_t {
+  Direct = 0,
+  Resample, // speed changes pitch
+  Stretch,  // speed keeps pitch
+};
+
+static int16_t gAudioBlocks[kAudioBlockCount][kPlayBlockSamples];
+static size_t gPlayBlockSrcPos[kAudioBlockCount] = {0};
+static size_t gAudioNextBlock = 0;
+static uint32_t gAudioQueueEndUs = 0; // when the last queued block finishes on the speaker
+static bool gPlayTraceFirstBlock = false; // next stream block is the clip's first (latency trace)
+static size_t gPlaySrcPos = 0;
+static size_t gPlayFlushLeft = 0;
+static PlayPath gPlayPath = PlayPath::Direct;
+static PolyphaseResampler gPlayResampler;
+static TimeStretcher gPlayStretch;
+
+static size_t playSourcePos() {
+  return (gPlayPath == PlayPath::Stretch) ? gPlayStretch.sourcePos() : gPlaySrcPos;
+}
+
+static size_t renderPlaySource(int16_t* out, size_t cap) {
+  if (gPlayPath == PlayPath::Stretch) {
+    return gPlayStretch.render(out, cap);
   }
-  if (!M5.Speaker.isRunning()) {
-    (void)M5.Speaker.begin();
+
+  if (gPlayPath == PlayPath::Direct) {
+    const size_t n = std::min(cap, gRecSamples - gPlaySrcPos);
+    memcpy(out, gRecPcm + gPlaySrcPos, n * sizeof(int16_t));
+    gPlaySrcPos += n;
+    return n;
+  }
+
+  // Resample: feed the clip, then a short run of zeros to flush the filter tail.
+  static const int16_t kZeros[PolyphaseResampler::kTaps] = {0};
+  size_t n = 0;
+  while (n < cap) {
+    const bool tail = (gPlaySrcPos >= gRecSamples);
+    if (tail && gPlayFlushLeft == 0) {
+      break;
+    }
+    const int16_t* in = tail ? kZeros : (gRecPcm + gPlaySrcPos);
+    const size_t avail = tail ? gPlayFlushLeft : (gRecSamples - gPlaySrcPos);
+    size_t used = 0;
+    n += gPlayResampler.process(in, avail, out + n, cap - n, &used);
+    if (tail) {
+      gPlayFlushLeft -= used;
+    } else {
+      gPlaySrcPos += used;
+    }
   }
-  M5.Speaker.setVolume(kMasterVolume);
+  return n;
 }
 
-static void ensureSpeakerOff() {
-  if (!M5.Speaker.isEnabled()) {
+// Stream pull for the mixer: the clip (at the selected speed), then enough silence for the
+// echo/reverb tails, through the effects chain in place.
+static size_t renderPlayBlock(int16_t* out, size_t cap) {
+  size_t n = renderPlaySource(out, cap);
+  if (!gEffects.enabled()) {
+    return n;
+  }
+  if (n < cap && gPlayTailLeft > 0) {
+    const size_t pad = std::min<size_t>(cap - n, gPlayTailLeft);
+    memset(out + n, 0, pad * sizeof(int16_t));
+    gPlayTailLeft -= (uint32_t)pad;
+    n += pad;
+  }
+  gEffects.process(out, n);
+  return n;
+}
+
+// Keeps the speaker queue topped up from the mixer. Cheap when the queue is full or the
+// mixer is idle; call every loop.
+static void pumpAudio() {
+  if (!gMixer.active() || !hal::Speaker.isRunning()) {
     return;
   }
-  if (M5.Speaker.isRunning()) {
-    M5.Speaker.stop();
-    // Give the speaker task a moment to drain/stop.
-    uint32_t t0 = millis();
-    while (M5.Speaker.isPlaying() && (millis() - t0) < 200) {
-      M5.update();
-      delay(1);
+  const size_t blockSamples = gMixer.streamActive() ? kPlayBlockSamples : kUiBlockSamples;
+  size_t inflight = hal::Speaker.isPlaying(kAudioChannel);
+  while (gMixer.active() && inflight < 2) {
+    // Blocks play back to back; an empty queue starts now.
+    const uint32_t nowUs = hal::micros();
+    const uint32_t startUs = (inflight == 0 || (int32_t)(gAudioQueueEndUs - nowUs) < 0) ? nowUs : gAudioQueueEndUs;
+    int16_t* block = gAudioBlocks[gAudioNextBlock];
+    gPlayBlockSrcPos[gAudioNextBlock] = playSourcePos();
+    const bool firstClipBlock = gPlayTraceFirstBlock && gMixer.streamActive();
+    const size_t n = gMixer.render(block, blockSamples, startUs);
+    if (n == 0) {
+      break;
+    }
+    (void)hal::Speaker.playRaw(block, n, gMixer.sampleRate(), kAudioChannel);
+    if (firstClipBlock) {
+      gPlayTraceFirstBlock = false;
+      gTrace.mark(LatencyTrace::Stage::PlayRaw, hal::micros());
+      gTrace.mark(LatencyTrace::Stage::FirstPlayed, startUs);
     }
-    M5.Speaker.end();
+    gAudioQueueEndUs = startUs + (uint32_t)(((uint64_t)n * 1000000u) / gMixer.sampleRate());
+    gAudioNextBlock = (gAudioNextBlock + 1) % kAudioBlockCount;
+    ++inflight;
   }
 }
 
-static void ensureMicOff() {
-  if (M5.Mic.isRunning()) {
-    M5.Mic.end();
+// Short UI sound through the mixer; returns immediately. Skipped while the mic owns the codec.
+static void playUiTone(float hz, uint16_t ms, AudioMixer::Wave wave) {
+  static constexpr AudioMixer::Envelope kUiEnvelope = {4, 25, 22000, 30};
+  static constexpr uint16_t kUiToneGain = 16384; // leaves headroom for a few overlapping sounds
+  if (hz <= 0.0f || gAudio.state() == AudioPath::State::MicActive || gAudio.state() == AudioPath::State::Transitioning || !gAudio.requestSpeaker()) {
+    return;
+  }
+  if (!gMixer.active()) {
+    gMixer.setSampleRate(kUiMixRateHz);
+  }
+  (void)gMixer.playTone(hz, ms, kUiToneGain, kUiEnvelope, wave, hal::micros());
+  pumpAudio();
+}
+
+// Source sample at the block currently on the speaker (for the playhead / meters).
+static size_t playbackPosition() {
+  const size_t inflight = hal::Speaker.isPlaying(kAudioChannel);
+  if (inflight == 0) {
+    return gMixer.streamActive() ? playSourcePos() : gRecSamples;
+  }
+  const size_t idx = (gAudioNextBlock + kAudioBlockCount - std::min(inflight, kAudioBlockCount)) % kAudioBlockCount;
+  return std::min(gPlayBlockSrcPos[idx], gRecSamples);
+}
+
+// Whole-clip loudness for the library index.
+static void measureClipLoudness(const int16_t* pcm, size_t n, float* rmsDbfs, float* peakDbfs) {
+  int peak = 0;
+  double sumsq = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    const int v = (int)pcm[i];
+    peak = std::max(peak, (v < 0) ? -v : v);
+    sumsq += (double)v * (double)v;
   }
+  const double rms = (n > 0) ? sqrt(sumsq / (double)n) / 32768.0 : 0.0;
+  *rmsDbfs = (rms > 0.0) ? (float)(20.0 * log10(rms)) : -99.9f;
+  *peakDbfs = (peak > 0) ? 20.0f * log10f((float)peak / 32768.0f) : -99.9f;
 }
 
-static void playToneIfEnabled(float hz, uint16_t ms, bool wait) {
-  if (!M5.Speaker.isEnabled() || hz <= 0.0f) {
+// Encodes the take in gRecPcm with the selected codec, decodes it back in place (so what
+// plays is what is stored) and adds it to the library as the newest, selected clip.
+static void storeTake() {
+  gLoadedClipId = 0;
+  if (gRecSamples == 0) {
     return;
   }
-  ensureSpeakerOn();
-  (void)M5.Speaker.tone(hz, ms);
-  if (!wait) {
+  const AudioCodec& codec = kCodecs[gRecCodecIndex];
+  if (!codec.encode(gRecPcm, gRecSamples, gRecAdpcm) || !codec.decode(gRecAdpcm, gRecPcm, gRecSamples)) {
     return;
   }
-  const uint32_t t0 = millis();
-  const uint32_t timeout = ms + 190;
-  while (M5.Speaker.isPlaying() && (millis() - t0) < timeout) {
-    M5.update();
-    delay(1);
+  hal::logf("[play] codec %s: %u -> %u bytes (%.1fx)\n", codec.name, (unsigned)(gRecSamples * sizeof(int16_t)), (unsigned)gRecAdpcm.size(), (float)(gRecSamples * sizeof(int16_t)) / (float)gRecAdpcm.size());
+
+  ClipLibrary::ClipInfo info;
+  info.createdMs = gRecStartMs;
+  info.samples = (uint32_t)gRecSamples;
+  info.capturedSamples = (uint32_t)gRecOrigSamples;
+  info.rateHz = gRecClipRateHz;
+  info.codec = (uint8_t)codec.id;
+  measureClipLoudness(gRecPcm, gRecSamples, &info.rmsDbfs, &info.peakDbfs);
+  const uint32_t id = gClips.makeRoom(gRecAdpcm.size()) ? gClips.store(gRecAdpcm.data(), gRecAdpcm.size(), info) : 0;
+  if (id == 0) {
+    hal::logf("[clip] not stored (library %s)\n", gClips.isReady() ? "full" : "unavailable");
+    return;
   }
+  gClipSel = 0;
+  gLoadedClipId = id;
+  hal::logf("[clip] stored #%lu  %u bytes  %u/%u pages free  %u clips\n", (unsigned long)id, (unsigned)gRecAdpcm.size(), (unsigned)gClips.freePages(), (unsigned)gClips.totalPages(), (unsigned)gClips.count());
 }
 
-static bool imaAdpcmEncodeBuffer(const int16_t* pcm, size_t samples, std::vector<uint8_t>& out);
-static bool imaAdpcmDecodeToBuffer(const std::vector<uint8_t>& in, int16_t* pcmOut, size_t samples);
+// Decodes a library clip into the working buffer (playback, meters and the overview use it).
+static bool loadClip(const ClipLibrary::ClipInfo& clip) {
+  if (clip.samples > gRecMaxSamples || !gClips.read(clip.id, gRecAdpcm) || !codecFor((CodecId)clip.codec).decode(gRecAdpcm, gRecPcm, clip.samples)) {
+    return false;
+  }
+  gRecSamples = clip.samples;
+  gRecOrigSamples = clip.capturedSamples;
+  gRecClipRateHz = clip.rateHz;
+  gRecWave.rebuild(gRecPcm, gRecSamples);
+  gLoadedClipId = clip.id;
+  hal::logf("[clip] load #%lu  %.2fs @ %lu Hz\n", (unsigned long)clip.id, (float)clip.samples / (float)clip.rateHz, (unsigned long)clip.rateHz);
+  return true;
+}
+
+static void selectNextClip() {
+  if (gClips.count() == 0) {
+    return;
+  }
+  gClipSel = (gClipSel + 1) % gClips.count();
+}
 
 static bool startPlayback() {
-  if (gRecSamples == 0 || !M5.Speaker.isEnabled()) {
+  if (!hal::Speaker.isEnabled()) {
+    return false;
+  }
+  const ClipLibrary::ClipInfo* clip = gClips.at(gClipSel);
+  if (clip != nullptr && clip->id != gLoadedClipId && !loadClip(*clip)) {
     return false;
   }
-  (void)imaAdpcmEncodeBuffer(gRecPcm, gRecSamples, gRecAdpcm);
-  (void)imaAdpcmDecodeToBuffer(gRecAdpcm, gRecPcm, gRecSamples);
-  (void)M5.Speaker.playRaw(gRecPcm, gRecSamples, kRecSampleRateHz, false, 1, -1, true);
-  gPlayStartMs = millis();
+  if (gRecSamples == 0) {
+    return false;
+  }
+
+  const uint16_t speedQ8 = kPlaySpeedsQ8[gPlaySpeedIndex];
+  gPlaySrcPos = 0;
+  if (speedQ8 == 256) {
+    gPlayPath = PlayPath::Direct;
+  } else if (gPlayKeepPitch) {
+    gPlayPath = PlayPath::Stretch;
+    gPlayStretch.start(gRecPcm, gRecSamples, speedQ8);
+  } else {
+    gPlayPath = PlayPath::Resample;
+    (void)gPlayResampler.configure((float)speedQ8 / 256.0f);
+    gPlayResampler.reset();
+    gPlayFlushLeft = PolyphaseResampler::kTaps;
+  }
+  gEffects.select(gEchoIndex, gReverbIndex, gPitchFxIndex);
+  gEffects.start(gRecClipRateHz);
+  gPlayTailLeft = gEffects.enabled() ? gEffects.tailSamples() : 0;
+
+  // The clip sets the mix rate; UI tones still ringing are re-pitched to match.
+  gMixer.setSampleRate(gRecClipRateHz);
+  if (gMixer.playStream(renderPlayBlock, 32768, hal::micros()) < 0) {
+    return false;
+  }
+  gPlayTraceFirstBlock = true;
+  pumpAudio();
+  gPlayStartMs = hal::millis();
   gPlayActive = true;
   gUiMode = UiMode::Playing;
   return true;
 }
 
+// --- Settings (KEY1 held + KEY2 press) ---
+struct SettingItem {
+  const char* label;
+  void (*format)(char* out, size_t len);
+  void (*cycle)();
+};
+
+static void formatRecRate(char* out, size_t len) {
+  snprintf(out, len, "%lu kHz (max %lus)", (unsigned long)(kRecRatesHz[gRecRateIndex] / 1000), (unsigned long)(gRecMaxMs / 1000));
+}
+
+static void cycleRecRate() {
+  gRecRateIndex = (uint8_t)((gRecRateIndex + 1) % kRecRateCount);
+  updateRecLimits();
+}
+
+static void formatPlaySpeed(char* out, size_t len) {
+  snprintf(out, len, "%.2fx", (float)kPlaySpeedsQ8[gPlaySpeedIndex] / 256.0f);
+}
+
+static void cyclePlaySpeed() {
+  gPlaySpeedIndex = (uint8_t)((gPlaySpeedIndex + 1) % kPlaySpeedCount);
+}
+
+static void formatPitchMode(char* out, size_t len) {
+  snprintf(out, len, "%s", gPlayKeepPitch ? "keep pitch" : "varispeed");
+}
+
+static void cyclePitchMode() {
+  gPlayKeepPitch = !gPlayKeepPitch;
+}
+
+static void formatCondition(char* out, size_t len) {
+  snprintf(out, len, "%s", gRecCondition ? "DC+AGC+limit" : "off (raw)");
+}
+
+static void cycleCondition() {
+  gRecCondition = !gRecCondition;
+}
+
+static void formatDenoise(char* out, size_t len) {
+  snprintf(out, len, "%s", gRecDenoise ? "on (fan/hum)" : "off");
+}
+
+static void cycleDenoise() {
+  gRecDenoise = !gRecDenoise;
+}
+
+static void formatTrimSilence(char* out, size_t len) {
+  snprintf(out, len, "%s", gRecTrimSilence ? "on" : "off");
+}
+
+static void cycleTrimSilence() {
+  gRecTrimSilence = !gRecTrimSilence;
+}
+
+static void formatCodec(char* out, size_t len) {
+  const AudioCodec& codec = kCodecs[gRecCodecIndex];
+  snprintf(out, len, "%s (%lu kbit/s)", codec.name, (unsigned long)(codec.bitsPerSample * kRecRatesHz[gRecRateIndex] / 1000));
+}
+
+static void cycleCodec() {
+  gRecCodecIndex = (uint8_t)((gRecCodecIndex + 1) % kCodecCount);
+}
+
+static void formatIdleSleep(char* out, size_t len) {
+  snprintf(out, len, "%s", gIdleLightSleep ? "light sleep" : "off (delay)");
+}
+
+static void cycleIdleSleep() {
+  gIdleLightSleep = !gIdleLightSleep;
+}
+
+static void formatEcho(char* out, size_t len) {
+  snprintf(out, len, "%s", kEchoPresets[gEchoIndex].name);
+}
+
+static void cycleEcho() {
+  gEchoIndex = (uint8_t)((gEchoIndex + 1) % kEchoPresetCount);
+}
+
+static void formatReverb(char* out, size_t len) {
+  snprintf(out, len, "%s", kReverbPresets[gReverbIndex].name);
+}
+
+static void cycleReverb() {
+  gReverbIndex = (uint8_t)((gReverbIndex + 1) % kReverbPresetCount);
+}
+
+static void formatPitchFx(char* out, size_t len) {
+  snprintf(out, len, "%s", kPitchPresets[gPitchFxIndex].name);
+}
+
+static void cyclePitchFx() {
+  gPitchFxIndex = (uint8_t)((gPitchFxIndex + 1) % kPitchPresetCount);
+}
+
+static void formatTelemetry(char* out, size_t len) {
+  snprintf(out, len, "KEY2 open (%lus samples)", (unsigned long)(Telemetry::kPeriodMs / 1000));
+}
+
+static void openTelemetry() {
+  gUiMode = UiMode::Telemetry;
+  gTelemetryDirty = true;
+}
+
+static const SettingItem kSettings[] = {
+  {"Rec rate", formatRecRate, cycleRecRate},
+  {"Play speed", formatPlaySpeed, cyclePlaySpeed},
+  {"Speed mode", formatPitchMode, cyclePitchMode},
+  {"Echo", formatEcho, cycleEcho},
+  {"Reverb", formatReverb, cycleReverb},
+  {"Pitch shift", formatPitchFx, cyclePitchFx},
+  {"Trim silence", formatTrimSilence, cycleTrimSilence},
+  {"Denoise", formatDenoise, cycleDenoise},
+  {"Conditioning", formatCondition, cycleCondition},
+  {"Codec", formatCodec, cycleCodec},
+  {"Idle sleep", formatIdleSleep, cycleIdleSleep},
+  {"Telemetry", formatTelemetry, openTelemetry},
+};
+static constexpr size_t kSettingsCount = sizeof(kSettings) / sizeof(kSettings[0]);
+static constexpr uint32_t kSettingsIdleExitMs = 10000;
+static uint8_t gSettingsIndex = 0;
+static uint32_t gSettingsLastInputMs = 0;
+
 static bool shouldDrawStatus(uint32_t now, uint32_t intervalMs) {
   if (now - gUiLastDrawMs <= intervalMs) {
     return false;
@@ -323,14 +806,13 @@ static bool shouldDrawStatus(uint32_t now, uint32_t intervalMs) {
 }
 
 static void drawImuDisabledScreen() {
+  gTrace.mark(LatencyTrace::Stage::RenderStart, hal::micros());
   setDisplayRotation(kPortraitRotation);
   frameSpritePortrait.fillScreen(bgColor);
   frameSpritePortrait.setTextDatum(middle_center);
   frameSpritePortrait.setTextColor(TFT_WHITE, bgColor);
   frameSpritePortrait.drawString("IMU disabled", frameSpritePortrait.width() / 2, frameSpritePortrait.height() / 2);
-  M5.Display.startWrite();
-  frameSpritePortrait.pushSprite(&M5.Display, 0, 0);
-  M5.Display.endWrite();
+  presentFrame(frameSpritePortrait);
 }
 
 static void drawSpectrumBarsVertical(lgfx::LGFX_Sprite& s, int x, int y, int w, int h, const uint8_t* bins, size_t binCount, uint16_t barColor, uint16_t bg) {
@@ -368,9 +850,52 @@ static void drawSpectrumBarsVertical(lgfx::LGFX_Sprite& s, int x, int y, int w,
   }
 }
 
-static void drawStatusScreen(const char* title, const char* line1, const char* line2, uint16_t accent, const uint8_t* spectrumBins = nullptr, size_t spectrumCount = 0) {
+static constexpr size_t kNoPlayhead = SIZE_MAX;
+
+// Full-width min/max thumbnail of the whole clip. Cost is O(w): one pyramid query per column.
+static void drawWaveformOverview(lgfx::LGFX_Sprite& s, int x, int y, int w, int h, const WaveformPyramid& wave, size_t playhead, uint16_t color, uint16_t bg) {
+  if (w <= 2 || h <= 2) {
+    return;
+  }
+
+  s.drawRect(x, y, w, h, TFT_DARKGREY);
+  s.fillRect(x + 1, y + 1, w - 2, h - 2, bg);
+
+  const int innerW = w - 2;
+  const int innerH = h - 2;
+  const size_t total = wave.samples();
+  if (total == 0) {
+    return;
+  }
+
+  const int half = innerH / 2;
+  const int mid = (y + 1) + half;
+  const size_t span = std::max<size_t>(1, total / (size_t)innerW);
+  for (int c = 0; c < innerW; ++c) {
+    const size_t begin = (total * (size_t)c) / (size_t)innerW;
+    const size_t end = (total * (size_t)(c + 1)) / (size_t)innerW;
+    const WavePeak pk = wave.query(begin, std::max(end, begin + 1), span);
+    if (pk.empty()) {
+      continue;
+    }
+    const int top = mid - ((int)pk.hi * half) / 128;
+    const int bot = mid - ((int)pk.lo * half) / 128;
+    s.drawFastVLine(x + 1 + c, top, std::max(1, bot - top + 1), color);
+  }
+
+  if (playhead != kNoPlayhead) {
+    const size_t p = std::min(playhead, total);
+    const int px = (x + 1) + (int)(((uint64_t)p * (uint64_t)(innerW - 1)) / (uint64_t)total);
+    s.drawFastVLine(px, y + 1, innerH, TFT_WHITE);
+  }
+}
+
+// Title, accent line and two text lines; the panel area below y=80 is left to the caller.
+static lgfx::LGFX_Sprite& beginStatusScreen(const char* title, const char* line1, const char* line2, uint16_t accent) {
+  gTrace.mark(LatencyTrace::Stage::RenderStart, hal::micros());
   // Status UI is displayed in landscape.
   setDisplayRotation(kStatusRotation);
+  ensureLandscapeSprite();
   auto& frameSprite = frameSpriteLandscape;
 
   frameSprite.fillScreen(bgColor);
@@ -387,25 +912,114 @@ static void drawStatusScreen(const char* title, const char* line1, const char* l
   frameSprite.setTextColor(TFT_LIGHTGREY, bgColor);
   frameSprite.drawString(line1 ? line1 : "", 8, 44);
   frameSprite.drawString(line2 ? line2 : "", 8, 60);
+  return frameSprite;
+}
 
-  // Optional: spectrum
-  if (spectrumBins != nullptr && spectrumCount > 0) {
-    const int barX = 8;
-    const int barY = 80;
-    const int barW = frameSprite.width() - 16;
-    const int barH = std::max(16, frameSprite.height() - barY - 28);
-    drawSpectrumBarsVertical(frameSprite, barX, barY, barW, barH, spectrumBins, spectrumCount, accent, bgColor);
-  }
-
+static void endStatusScreen(lgfx::LGFX_Sprite& frameSprite) {
   // Footer: buffer/mic/speaker quick status
   char footer[96];
-  snprintf(footer, sizeof(footer), "Mic:%s  Spk:%s  Buf:%s", M5.Mic.isEnabled() ? "ON" : "OFF", M5.Speaker.isEnabled() ? "ON" : "OFF", gRecPcm ? "OK" : "NO");
+  snprintf(footer, sizeof(footer), "Mic:%s  Spk:%s  Buf:%s", hal::Mic.isEnabled() ? "ON" : "OFF", hal::Speaker.isEnabled() ? "ON" : "OFF", gRecPcm ? "OK" : "NO");
   frameSprite.setTextColor(TFT_DARKGREY, bgColor);
   frameSprite.drawString(footer, 8, frameSprite.height() - 14);
 
-  M5.Display.startWrite();
-  frameSprite.pushSprite(&M5.Display, 0, 0);
-  M5.Display.endWrite();
+  presentFrame(frameSprite);
+}
+
+static void drawStatusScreen(const char* title, const char* line1, const char* line2, uint16_t accent, const uint8_t* spectrumBins = nullptr, size_t spectrumCount = 0, const WaveformPyramid* wave = nullptr, size_t playhead = kNoPlayhead) {
+  auto& frameSprite = beginStatusScreen(title, line1, line2, accent);
+
+  // Optional: clip overview (top strip) and spectrum (below it).
+  const int areaX = 8;
+  const int areaW = frameSprite.width() - 16;
+  int areaY = 80;
+  const bool hasWave = (wave != nullptr && wave->samples() > 0);
+  const bool hasSpectrum = (spectrumBins != nullptr && spectrumCount > 0);
+  if (hasWave) {
+    const int areaH = std::max(16, frameSprite.height() - areaY - 28);
+    const int waveH = hasSpectrum ? std::min(18, areaH / 2) : areaH;
+    drawWaveformOverview(frameSprite, areaX, areaY, areaW, waveH, *wave, playhead, accent, bgColor);
+    areaY += waveH + 2;
+  }
+  if (hasSpectrum) {
+    const int barH = std::max(16, frameSprite.height() - areaY - 28);
+    drawSpectrumBarsVertical(frameSprite, areaX, areaY, areaW, barH, spectrumBins, spectrumCount, accent, bgColor);
+  }
+
+  endStatusScreen(frameSprite);
+}
+
+// Latest sample as text, then free-heap and CPU-load history (oldest left) in the panel area.
+static void drawTelemetryScreen() {
+  char l1[64];
+  char l2[64];
+  if (gTelemetry.size() == 0) {
+    snprintf(l1, sizeof(l1), "Sampling every %lus...", (unsigned long)(Telemetry::kPeriodMs / 1000));
+    snprintf(l2, sizeof(l2), "KEY1 / KEY2 exit");
+    endStatusScreen(beginStatusScreen("TELEMETRY", l1, l2, TFT_MAGENTA));
+    return;
+  }
+
+  const Telemetry::Sample& s = gTelemetry.sample(0);
+  snprintf(l1, sizeof(l1), "Heap %luK min %luK blk %luK frag %u%%", (unsigned long)(s.heapFree / 1024), (unsigned long)(s.heapMin / 1024), (unsigned long)(s.heapLargest / 1024),
+           (unsigned)Telemetry::fragmentationPct(s.heapFree, s.heapLargest));
+  if (s.loadPct[0] == Telemetry::kLoadUnknown) {
+    snprintf(l2, sizeof(l2), "PSRAM %luK min %luK  CPU n/a", (unsigned long)(s.psramFree / 1024), (unsigned long)(s.psramMin / 1024));
+  } else if (gTelemetry.coreCount() > 1) {
+    snprintf(l2, sizeof(l2), "PSRAM %luK min %luK  CPU %u%% / %u%%", (unsigned long)(s.psramFree / 1024), (unsigned long)(s.psramMin / 1024), (unsigned)s.loadPct[0], (unsigned)s.loadPct[1]);
+  } else {
+    snprintf(l2, sizeof(l2), "PSRAM %luK min %luK  CPU %u%%", (unsigned long)(s.psramFree / 1024), (unsigned long)(s.psramMin / 1024), (unsigned)s.loadPct[0]);
+  }
+  auto& frameSprite = beginStatusScreen("TELEMETRY", l1, l2, TFT_MAGENTA);
+
+  // Tightest stacks first (free bytes at their high-water mark), as many as fit one row.
+  static constexpr size_t kStackRowChars = 38;
+  char stacks[kStackRowChars + 1];
+  size_t len = (size_t)snprintf(stacks, sizeof(stacks), "Stk");
+  for (size_t i = 0; i < gTelemetry.taskCount(); ++i) {
+    const Telemetry::TaskStack& t = gTelemetry.task(i);
+    char entry[32];
+    const size_t n = (size_t)snprintf(entry, sizeof(entry), " %s:%lu", t.name, (unsigned long)t.minFreeBytes);
+    if (len + n > kStackRowChars) {
+      break;
+    }
+    memcpy(stacks + len, entry, n + 1);
+    len += n;
+  }
+  frameSprite.drawString(stacks, 8, 76);
+
+  // One slot per history entry, newest at the right. Free heap is auto-ranged between the worst
+  // and best sample in the window (floor at 20%), so a slow leak reads as a falling staircase.
+  const size_t n = gTelemetry.size();
+  uint32_t heapHi = 0;
+  uint32_t heapLo = UINT32_MAX;
+  for (size_t age = 0; age < n; ++age) {
+    heapHi = std::max(heapHi, gTelemetry.sample(age).heapFree);
+    heapLo = std::min(heapLo, gTelemetry.sample(age).heapFree);
+  }
+  uint8_t heapBins[Telemetry::kHistory] = {0};
+  uint8_t cpuBins[Telemetry::kHistory] = {0};
+  for (size_t age = 0; age < n; ++age) {
+    const Telemetry::Sample& h = gTelemetry.sample(age);
+    const size_t i = Telemetry::kHistory - 1 - age;
+    heapBins[i] = (heapHi > heapLo) ? (uint8_t)(20u + ((uint64_t)(h.heapFree - heapLo) * 80u) / (heapHi - heapLo)) : 100;
+    cpuBins[i] = (h.loadPct[0] == Telemetry::kLoadUnknown) ? 0 : std::max(h.loadPct[0], h.loadPct[1]);
+  }
+  const int areaY = 90;
+  const int areaH = std::max(16, frameSprite.height() - areaY - 18);
+  const int halfW = (frameSprite.width() - 20) / 2;
+  drawSpectrumBarsVertical(frameSprite, 8, areaY, halfW, areaH, heapBins, Telemetry::kHistory, TFT_MAGENTA, bgColor);
+  drawSpectrumBarsVertical(frameSprite, 12 + halfW, areaY, halfW, areaH, cpuBins, Telemetry::kHistory, TFT_ORANGE, bgColor);
+
+  endStatusScreen(frameSprite);
+}
+
+static void drawSettingsScreen() {
+  const SettingItem& item = kSettings[gSettingsIndex];
+  char value[40];
+  item.format(value, sizeof(value));
+  char l1[64];
+  snprintf(l1, sizeof(l1), "[%u/%u] %s: %s", (unsigned)(gSettingsIndex + 1), (unsigned)kSettingsCount, item.label, value);
+  drawStatusScreen("SETTINGS", l1, "KEY1 next  KEY2 change  hold KEY1 exit", TFT_CYAN);
 }
 
 static void computeSpectrumFromPcmWindow(const int16_t* pcm, size_t totalSamples, size_t windowEndSample) {
@@ -439,7 +1053,7 @@ static void computeSpectrumFromPcmWindow(const int16_t* pcm, size_t totalSamples
   float raw[kRecSpectrumBins];
   for (size_t bi = 0; bi < kRecSpectrumBins; ++bi) {
     const float f = kCentersHz[bi];
-    int k = (int)lroundf((f * (float)N) / (float)kRecSampleRateHz);
+    int k = (int)lroundf((f * (float)N) / (float)gRecClipRateHz);
     if (k < 1) k = 1;
     if (k > (int)N / 2 - 1) k = (int)N / 2 - 1;
     const float w = 2.0f * PI * (float)k / (float)N;
@@ -535,189 +1149,12 @@ static void computeAudioMetricsFromPcmWindow(const int16_t* pcm, size_t totalSam
   gRecMetricsValid = true;
 }
 
-struct IMAAdpcmState {
-  int predictor = 0;
-  int index = 0;
-};
-
-static constexpr int kImaStepTable[89] = {
-  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
-  34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
-  157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
-  724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
-  3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
-  15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
-};
-
-static constexpr int8_t kImaIndexTable[16] = {
-  -1, -1, -1, -1, 2, 4, 6, 8,
-  -1, -1, -1, -1, 2, 4, 6, 8
-};
-
-static uint8_t imaAdpcmEncodeNibble(int16_t sample, IMAAdpcmState& st) {
-  int predictor = st.predictor;
-  int index = st.index;
-  int step = kImaStepTable[index];
-
-  int diff = (int)sample - predictor;
-  uint8_t code = 0;
-  if (diff < 0) {
-    code |= 8;
-    diff = -diff;
-  }
-
-  int delta = step >> 3;
-  if (diff >= step) {
-    code |= 4;
-    diff -= step;
-    delta += step;
-  }
-  step >>= 1;
-  if (diff >= step) {
-    code |= 2;
-    diff -= step;
-    delta += step;
-  }
-  step >>= 1;
-  if (diff >= step) {
-    code |= 1;
-    delta += step;
-  }
-
-  if (code & 8) {
-    predictor -= delta;
-  } else {
-    predictor += delta;
-  }
-
-  if (predictor > 32767) predictor = 32767;
-  if (predictor < -32768) predictor = -32768;
-
-  index += kImaIndexTable[code & 0x0F];
-  if (index < 0) index = 0;
-  if (index > 88) index = 88;
-
-  st.predictor = predictor;
-  st.index = index;
-  return (uint8_t)(code & 0x0F);
-}
-
-static int16_t imaAdpcmDecodeNibble(uint8_t code, IMAAdpcmState& st) {
-  int predictor = st.predictor;
-  int index = st.index;
-  int step = kImaStepTable[index];
-
-  int diff = step >> 3;
-  if (code & 4) diff += step;
-  if (code & 2) diff += (step >> 1);
-  if (code & 1) diff += (step >> 2);
-
-  if (code & 8) predictor -= diff;
-  else predictor += diff;
-
-  if (predictor > 32767) predictor = 32767;
-  if (predictor < -32768) predictor = -32768;
-
-  index += kImaIndexTable[code & 0x0F];
-  if (index < 0) index = 0;
-  if (index > 88) index = 88;
-
-  st.predictor = predictor;
-  st.index = index;
-  return (int16_t)predictor;
-}
-
-static bool imaAdpcmEncodeBuffer(const int16_t* pcm, size_t samples, std::vector<uint8_t>& out) {
-  out.clear();
-  if (samples == 0 || pcm == nullptr) {
-    return false;
-  }
-
-  // Header: predictor (LE int16), index (uint8), reserved (uint8)
-  IMAAdpcmState st;
-  st.predictor = pcm[0];
-  st.index = 0;
-
-  const size_t payloadNibbles = (samples > 1) ? (samples - 1) : 0;
-  const size_t payloadBytes = (payloadNibbles + 1) / 2;
-  out.reserve(4 + payloadBytes);
-
-  out.push_back((uint8_t)(st.predictor & 0xFF));
-  out.push_back((uint8_t)((st.predictor >> 8) & 0xFF));
-  out.push_back((uint8_t)(st.index & 0xFF));
-  out.push_back(0);
-
-  uint8_t packed = 0;
-  bool highNibble = false;
-  for (size_t i = 1; i < samples; ++i) {
-    const uint8_t nib = imaAdpcmEncodeNibble(pcm[i], st);
-    if (!highNibble) {
-      packed = nib;
-      highNibble = true;
-    } else {
-      packed |= (uint8_t)(nib << 4);
-      out.push_back(packed);
-      highNibble = false;
-      packed = 0;
-    }
-  }
-  if (highNibble) {
-    out.push_back(packed);
-  }
-  return true;
-}
-
-static bool imaAdpcmDecodeToBuffer(const std::vector<uint8_t>& in, int16_t* pcmOut, size_t samples) {
-  if (pcmOut == nullptr || samples == 0) {
-    return false;
-  }
-  if (in.size() < 4) {
-    return false;
-  }
-
-  IMAAdpcmState st;
-  st.predictor = (int16_t)((int)in[0] | ((int)in[1] << 8));
-  st.index = (int)in[2];
-  if (st.index < 0) st.index = 0;
-  if (st.index > 88) st.index = 88;
-
-  pcmOut[0] = (int16_t)st.predictor;
-  if (samples == 1) {
-    return true;
-  }
-
-  size_t pcmIdx = 1;
-  for (size_t i = 4; i < in.size() && pcmIdx < samples; ++i) {
-    const uint8_t b = in[i];
-    const uint8_t lo = b & 0x0F;
-    const uint8_t hi = (b >> 4) & 0x0F;
-
-    pcmOut[pcmIdx++] = imaAdpcmDecodeNibble(lo, st);
-    if (pcmIdx < samples) {
-      pcmOut[pcmIdx++] = imaAdpcmDecodeNibble(hi, st);
-    }
-  }
-  return pcmIdx == samples;
-}
-
-void setup() {
-  auto cfg = M5.config();
-  cfg.serial_baudrate = 115200;
-  cfg.internal_mic = true;
-  cfg.internal_spk = true;
-  M5.begin(cfg);
-
-  bgIndex = 0;
-  bgColor = kBgPalette16[bgIndex];
-
-  // 70% volume (0..255).
-  ensureSpeakerOn();
-
+static void initRecBuffer() {
   // Allocate recording buffer (prefer PSRAM if available).
   // Goal: significantly more than 3 seconds, but keep headroom for graphics/sound.
   // We downscale until allocation succeeds.
-  const uint32_t freePsram = (uint32_t)ESP.getFreePsram();
-  const uint32_t freeHeap = (uint32_t)ESP.getFreeHeap();
+  const uint32_t freePsram = (uint32_t)hal::freePsram();
+  const uint32_t freeHeap = (uint32_t)hal::freeHeap();
 
   // Leave generous headroom for sprites + runtime allocations.
   const uint32_t psramBudget = (freePsram > (512u * 1024u)) ? (freePsram - (512u * 1024u)) : 0;
@@ -745,10 +1182,7 @@ void setup() {
   size_t trySamples = targetSamples;
   while (trySamples >= minSamples && gRecPcm == nullptr) {
     const size_t bytes = trySamples * sizeof(int16_t);
-    gRecPcm = (int16_t*)ps_malloc(bytes);
-    if (!gRecPcm) {
-      gRecPcm = (int16_t*)malloc(bytes);
-    }
+    gRecPcm = (int16_t*)hal::allocLarge(bytes);
     if (!gRecPcm) {
       trySamples /= 2;
       // Keep alignment sane.
@@ -759,131 +1193,338 @@ void setup() {
     }
   }
 
-  Serial.println();
-  Serial.println("[autogarden] StickS3 audio record/playback");
-  Serial.printf("Mic enabled: %d\n", (int)M5.Mic.isEnabled());
-  Serial.printf("Speaker enabled: %d\n", (int)M5.Speaker.isEnabled());
-  Serial.printf("Rec buffer: %s (%u bytes)\n", gRecPcm ? "OK" : "FAILED", (unsigned)(gRecMaxSamples * sizeof(int16_t)));
-  Serial.printf("Rec max: %lums (~%lus)\n", (unsigned long)gRecMaxMs, (unsigned long)(gRecMaxMs / 1000));
-  Serial.printf("Free heap: %u bytes\n", (unsigned)ESP.getFreeHeap());
-  Serial.printf("Free PSRAM: %u bytes\n", (unsigned)ESP.getFreePsram());
+  // Waveform overview pyramid (~3% of the PCM buffer), same memory preference.
+  if (gRecPcm != nullptr) {
+    const size_t waveBytes = WaveformPyramid::bytesFor(gRecMaxSamples);
+    void* waveMem = hal::allocLarge(waveBytes);
+    (void)gRecWave.init(waveMem, waveBytes, gRecMaxSamples);
+  }
+
+  // Noise suppressor scratch (~8 KB) and the FFT tables it shares.
+  if (gRecPcm != nullptr && gFft.configure(NoiseSuppressor::kFrame)) {
+    void* denoiseMem = hal::allocLarge(NoiseSuppressor::bytesFor());
+    (void)gRecDenoiser.init(denoiseMem, NoiseSuppressor::bytesFor(), &gFft);
+  }
+
+  hal::logf("Rec buffer: %s (%u bytes)\n", gRecPcm ? "OK" : "FAILED", (unsigned)(gRecMaxSamples * sizeof(int16_t)));
+  hal::logf("Rec max: %lums (~%lus)\n", (unsigned long)gRecMaxMs, (unsigned long)(gRecMaxMs / 1000));
+  hal::logf("Wave overview: %s (%u bytes)\n", gRecWave.isReady() ? "OK" : "FAILED", (unsigned)WaveformPyramid::bytesFor(gRecMaxSamples));
+  hal::logf("Denoiser: %s (%u bytes)\n", gRecDenoiser.isReady() ? "OK" : "FAILED", (unsigned)NoiseSuppressor::bytesFor());
+}
+
+static void initSpeaker() {
+  (void)gAudio.requestSpeaker();
+  hal::logf("Speaker enabled: %d\n", (int)hal::Speaker.isEnabled());
+}
+
+static void initClipLibrary() {
+  // Clip library arena (PSRAM preferred); halve until it fits.
+  for (size_t arenaBytes = kClipArenaBytes; arenaBytes >= 64u * 1024u && !gClips.isReady(); arenaBytes /= 2) {
+    void* arena = hal::allocLarge(arenaBytes);
+    if (arena != nullptr) {
+      (void)gClips.init(arena, arenaBytes);
+    }
+  }
+  hal::logf("Clip library: %s (%u pages of %u bytes)\n", gClips.isReady() ? "OK" : "FAILED", (unsigned)gClips.totalPages(), (unsigned)ClipLibrary::kPageBytes);
+}
+
+static void initEffects() {
+  // Effects delay lines (PSRAM preferred); playback stays dry without them.
+  void* fxMem = hal::allocLarge(EffectsChain::bytesFor(EffectsChain::kMaxRateHz));
+  (void)gEffects.init(fxMem, EffectsChain::bytesFor(EffectsChain::kMaxRateHz));
+  hal::logf("Effects: %s (%u bytes)\n", gEffects.isReady() ? "OK" : "FAILED", (unsigned)EffectsChain::bytesFor(EffectsChain::kMaxRateHz));
+}
+
+static void logBootPhase(BootProfile::Phase phase, uint32_t startUs) {
+  const bool wasReady = gBoot.ready();
+  gBoot.record(phase, startUs, hal::micros());
+  char line[64];
+  (void)gBoot.formatPhase(phase, line, sizeof(line));
+  hal::logf("[boot] %s\n", line);
+  if (gBoot.ready() && !wasReady) {
+    hal::logf("[boot] ready-to-record %.1f ms\n", (float)gBoot.readyUs() / 1000.0f);
+  }
+  if (gBoot.complete()) {
+    char summary[80];
+    (void)gBoot.formatSummary(summary, sizeof(summary));
+    hal::logf("[boot] %s\n", summary);
+    hal::logf("Free heap: %u bytes\n", (unsigned)hal::freeHeap());
+    hal::logf("Free PSRAM: %u bytes\n", (unsigned)hal::freePsram());
+  }
+}
+
+// Ready-to-record first (buffer, REC screen, speaker for the beep), then what only a finished
+// take or playback needs. The buffer is sized before the landscape sprite takes its heap share.
+struct DeferredInit {
+  BootProfile::Phase phase;
+  void (*run)();
+};
+static const DeferredInit kDeferredInit[] = {
+  {BootProfile::Phase::RecBuffer, initRecBuffer},
+  {BootProfile::Phase::Landscape, ensureLandscapeSprite},
+  {BootProfile::Phase::Speaker, initSpeaker},
+  {BootProfile::Phase::ClipLibrary, initClipLibrary},
+  {BootProfile::Phase::Effects, initEffects},
+};
+static constexpr size_t kDeferredInitCount = sizeof(kDeferredInit) / sizeof(kDeferredInit[0]);
+static size_t gDeferredInitNext = 0;
+
+static bool stepDeferredInit() {
+  if (gDeferredInitNext >= kDeferredInitCount) {
+    return false;
+  }
+  const DeferredInit& step = kDeferredInit[gDeferredInitNext++];
+  const uint32_t t0 = hal::micros();
+  step.run();
+  logBootPhase(step.phase, t0);
+  return true;
+}
+
+// Called before anything that needs the deferred resources (KEY2, playback, settings).
+static void finishDeferredInit() {
+  while (stepDeferredInit()) {
+  }
+}
+
+void setup() {
+  const uint32_t halStartUs = hal::micros();
+  hal::begin();
+  logBootPhase(BootProfile::Phase::Hal, halStartUs);
+
+  bgIndex = 0;
+  bgColor = kBgPalette16[bgIndex];
+  gAudio.begin(kMasterVolume, &gTrace);
+
+  // Only what the first frame needs runs here; speaker, audio buffers and the landscape
+  // sprite follow in the loop's idle gaps (stepDeferredInit) or on first use.
+  const uint32_t frameStartUs = hal::micros();
 
   // Baseline: "upright" (USB-C down, GPIO up) should read normally.
   // We'll rotate the *text* smoothly, so keep the screen in portrait.
   setDisplayRotation(kPortraitRotation);
 
-  imuOk = M5.Imu.isEnabled();
+  imuOk = hal::Imu.isEnabled();
+  gSensors.begin(hal::millis());
+  gTelemetry.begin(hal::millis());
 
-  // Full-screen frame buffer (double buffering) to prevent flicker/tearing.
+  // Full-screen frame buffer (double buffering) to prevent flicker/tearing. The first push
+  // covers the whole panel, so no separate fillScreen beforehand.
   frameSpritePortrait.setColorDepth(16);
-  frameSpritePortrait.createSprite(M5.Display.width(), M5.Display.height());
-
-  // Landscape buffer for REC/PLAY UI.
-  setDisplayRotation(kStatusRotation);
-  frameSpriteLandscape.setColorDepth(16);
-  frameSpriteLandscape.createSprite(M5.Display.width(), M5.Display.height());
-  setDisplayRotation(kPortraitRotation);
-
-  M5.Display.fillScreen(bgColor);
-  frameSpritePortrait.fillScreen(TFT_BLACK);
+  frameSpritePortrait.createSprite(hal::Display.width(), hal::Display.height());
 
   if (imuOk) {
     float ax = 0.0f, ay = 0.0f, az = 0.0f;
-    (void)M5.Imu.update();
-    (void)M5.Imu.getAccel(&ax, &ay, &az);
-    drawAxesScreen(ax, ay, az);
+    (void)hal::Imu.update();
+    (void)hal::Imu.getAccel(&ax, &ay, &az);
+    gAccel.update(ax, ay, az, hal::millis());
+    drawAxesScreen();
   } else {
     drawImuDisabledScreen();
   }
+  gRenderGov.reset(hal::millis());
+  logBootPhase(BootProfile::Phase::FirstFrame, frameStartUs);
+
+  hal::logf("\n[autogarden] StickS3 audio record/playback\n");
+  hal::logf("Mic enabled: %d\n", (int)hal::Mic.isEnabled());
+
+#if AXES_ECHO_BENCH
+  runBenchmarks();
+#endif
 }
 
 void loop() {
-  M5.update();
+  hal::update();
+  gAudio.poll();
+  pumpAudio();
+
+  (void)gSensors.poll(hal::millis());
+  (void)gTrace.collect();
+  if (gTelemetry.poll(hal::millis())) {
+    char record[160];
+    (void)gTelemetry.formatRecord(record, sizeof(record));
+    hal::logf("[tele] %s\n", record);
+    gTelemetryDirty = true;
+  }
 
-  static uint32_t lastDrawMs = 0;
+  gLoopStats.wake(loopStatsMode(), hal::millis());
+  if (gLoopStats.roll(hal::millis())) {
+    logLoopStats();
+  }
+
+  // Any button edge brings the axes screen back to full rate before it is handled.
+  if (hal::BtnA.wasPressed() || hal::BtnA.wasReleased() || hal::BtnB.wasPressed() || hal::BtnB.wasReleased()) {
+    gRenderGov.wake(hal::millis());
+  }
 
   // KEY1 / BtnA:
   // - short click: cycle background color (existing behavior)
   // - long press (~650ms): replay last recording (PLAY)
   static bool btnAHoldHandled = false;
+
+  // KEY1 held + KEY2 press: open settings (instead of recording).
+  if (gUiMode == UiMode::Normal && hal::BtnA.isPressed() && hal::BtnB.wasPressed()) {
+    finishDeferredInit(); // rows show buffer-derived limits and the library
+    gUiMode = UiMode::Settings;
+    btnAHoldHandled = true;
+    gSkipNextBtnAClick = true;
+    gSettingsLastInputMs = hal::millis();
+    drawSettingsScreen();
+    hal::delay(1);
+    return;
+  }
+
+  // Settings: KEY1 click = next item, KEY2 press = change value, KEY1 hold (or idle) = exit.
+  if (gUiMode == UiMode::Settings) {
+    const uint32_t now = hal::millis();
+    bool dirty = false;
+    if (hal::BtnA.wasClicked()) {
+      if (gSkipNextBtnAClick) {
+        gSkipNextBtnAClick = false;
+      } else {
+        gSettingsIndex = (uint8_t)((gSettingsIndex + 1) % kSettingsCount);
+        gSettingsLastInputMs = now;
+        dirty = true;
+      }
+    }
+    if (hal::BtnB.wasPressed()) {
+      kSettings[gSettingsIndex].cycle();
+      gSettingsLastInputMs = now;
+      dirty = true;
+      if (gUiMode != UiMode::Settings) {
+        hal::delay(1);
+        return;
+      }
+    }
+
+    if (!hal::BtnA.isPressed()) {
+      btnAHoldHandled = false;
+    }
+    const bool holdExit = !btnAHoldHandled && hal::BtnA.pressedFor(650);
+    if (holdExit || (now - gSettingsLastInputMs) > kSettingsIdleExitMs) {
+      if (holdExit) {
+        btnAHoldHandled = true;
+        gSkipNextBtnAClick = true;
+      }
+      gUiMode = UiMode::Normal;
+      gRenderGov.wake(hal::millis());
+      hal::delay(1);
+      return;
+    }
+
+    if (dirty || shouldDrawStatus(now, 250)) {
+      drawSettingsScreen();
+    }
+    hal::delay(1);
+    return;
+  }
+
+  // Telemetry: redraw per sample; KEY1 click or KEY2 press returns to the axes screen.
+  if (gUiMode == UiMode::Telemetry) {
+    bool leave = hal::BtnB.wasPressed();
+    if (hal::BtnA.wasClicked()) {
+      if (gSkipNextBtnAClick) {
+        gSkipNextBtnAClick = false;
+      } else {
+        leave = true;
+      }
+    }
+    if (leave) {
+      gUiMode = UiMode::Normal;
+      gRenderGov.wake(hal::millis());
+      hal::delay(1);
+      return;
+    }
+    if (gTelemetryDirty) {
+      gTelemetryDirty = false;
+      drawTelemetryScreen();
+    }
+    // Nothing animates here; sleep long enough that the page barely shows in its own CPU load.
+    hal::delay(gMixer.active() ? 4 : 20);
+    return;
+  }
+
   if (gUiMode == UiMode::Normal) {
-    if (M5.BtnA.isPressed()) {
-      if (!btnAHoldHandled && M5.BtnA.pressedFor(650)) {
+    if (hal::BtnA.isPressed()) {
+      if (!btnAHoldHandled && hal::BtnA.pressedFor(650)) {
         btnAHoldHandled = true;
         gSkipNextBtnAClick = true;
 
-        if (!gPlayActive && !gRecActive && !gRecReadyWaitRelease && gRecSamples > 0) {
-          ensureMicOff();
-          ensureSpeakerOn();
+        finishDeferredInit();
+        if (!gPlayActive && !gRecActive && !gRecReadyWaitRelease && (gRecSamples > 0 || gClips.count() > 0)) {
+          (void)gAudio.requestSpeaker();
           (void)startPlayback();
         } else {
           // No recording available (or busy) -> subtle error tone.
-          playToneIfEnabled(220.0f, 60, false);
+          playUiTone(220.0f, 60, AudioMixer::Wave::Soft);
         }
 
         // Force redraw immediately.
-        lastDrawMs = 0;
+        gRenderGov.wake(hal::millis());
       }
     } else {
       btnAHoldHandled = false;
     }
   }
 
-  if (M5.BtnA.wasClicked()) {
+  if (hal::BtnA.wasClicked()) {
     if (gSkipNextBtnAClick) {
       gSkipNextBtnAClick = false;
       // Swallow click generated by long-press release.
     } else {
+    gTrace.mark(LatencyTrace::Stage::ButtonEdge, hal::BtnA.edgeUs(), LatencyTrace::Path::BgColor);
     bgIndex = static_cast<uint8_t>((bgIndex + 1) % kBgPaletteCount);
     bgColor = kBgPalette16[bgIndex];
 
     // Play a short tone for each color except black.
     if (bgIndex != 0) {
-      playToneIfEnabled(kToneHz16[bgIndex], 90, false);
+      playUiTone(kToneHz16[bgIndex], 90, AudioMixer::Wave::Sine);
     }
 
     // Force redraw immediately.
-    lastDrawMs = 0;
+    gRenderGov.wake(hal::millis());
     }
   }
 
   // If we're playing back, keep a simple status screen until playback finishes.
   if (gPlayActive) {
-    if (!M5.Speaker.isPlaying()) {
+    if (!gMixer.streamActive() && !hal::Speaker.isPlaying()) {
       gPlayActive = false;
       gUiMode = UiMode::Normal;
-      lastDrawMs = 0;
+      gRenderGov.wake(hal::millis());
     } else {
-      const uint32_t now = millis();
+      const uint32_t now = hal::millis();
       if (shouldDrawStatus(now, 100)) {
-        const uint32_t elapsedMs = now - gPlayStartMs;
-        size_t pos = (size_t)(((uint64_t)elapsedMs * (uint64_t)kRecSampleRateHz) / 1000ull);
-        if (pos > gRecSamples) {
-          pos = gRecSamples;
-        }
+        const size_t pos = playbackPosition();
         computeSpectrumFromPcmWindow(gRecPcm, gRecSamples, pos);
         computeAudioMetricsFromPcmWindow(gRecPcm, gRecSamples, pos);
         char l1[64];
         char l2[64];
-        snprintf(l1, sizeof(l1), "playing... pos:%u/%u", (unsigned)pos, (unsigned)gRecSamples);
+        snprintf(l1, sizeof(l1), "pos:%u/%u  take %.1fs (orig %.1fs)", (unsigned)pos, (unsigned)gRecSamples, (float)gRecSamples / (float)gRecClipRateHz, (float)gRecOrigSamples / (float)gRecClipRateHz);
         if (gRecMetricsValid) {
           snprintf(l2, sizeof(l2), "RMS % .1f dBFS  PEAK % .1f dBFS  CLIP %0.1f%%", gRecRmsDbfs, gRecPeakDbfs, gRecClipPercent);
         } else {
           snprintf(l2, sizeof(l2), "RMS -- dBFS  PEAK -- dBFS  CLIP --%%");
         }
-        drawStatusScreen("PLAY", l1, l2, TFT_GREEN, gRecSpectrum, kRecSpectrumBins);
+        drawStatusScreen("PLAY", l1, l2, TFT_GREEN, gRecSpectrum, kRecSpectrumBins, &gRecWave, pos);
       }
-      delay(1);
+      hal::delay(1);
       return;
     }
   }
 
   // KEY2 / BtnB: press & hold to record up to 3 seconds, release to playback.
   // Beep once when recording starts so it's obvious.
-  if (!gRecActive && !gRecReadyWaitRelease && gRecPcm != nullptr && M5.Mic.isEnabled()) {
-    if (M5.BtnB.wasPressed()) {
-      gRecStartRequested = true;
-      gUiMode = UiMode::RecordBeep;
+  if (!gRecActive && !gRecReadyWaitRelease && !gRecBeepPending && hal::Mic.isEnabled()) {
+    if (hal::BtnB.wasPressed()) {
+      // A press before the deferred boot steps are done pays for them here (and in rec-start).
+      gTrace.mark(LatencyTrace::Stage::ButtonEdge, hal::BtnB.edgeUs(), LatencyTrace::Path::RecStart);
+      finishDeferredInit();
+      if (gRecPcm != nullptr) {
+        gRecStartRequested = true;
+        gUiMode = UiMode::RecordBeep;
+      } else {
+        gTrace.mark(LatencyTrace::Stage::Cancel, hal::micros(), LatencyTrace::Path::RecStart);
+      }
     }
   }
 
@@ -891,35 +1532,71 @@ void loop() {
     gRecStartRequested = false;
 
     // Make sure speaker is usable for the beep.
-    ensureMicOff();
-
-    // Record-start beep (played before recording to avoid capturing the beep).
-    playToneIfEnabled(1200.0f, 60, true);
+    (void)gAudio.requestSpeaker();
+
+    // Record-start beep (played before recording to avoid capturing the beep). Other sounds
+    // are cut so the mic starts as soon as the beep has drained; loop() keeps running meanwhile.
+    gMixer.stopAll();
+    playUiTone(1200.0f, kRecBeepMs, AudioMixer::Wave::Sine);
+    gRecBeepDeadlineMs = hal::millis() + kRecBeepMs + 190;
+    gRecBeepPending = true;
+  }
 
-    // IMPORTANT: enabling the mic reconfigures the ES8311 and will break audio output
-    // until the speaker is re-initialized. Turn speaker off before enabling mic.
-    ensureSpeakerOff();
+  if (gRecBeepPending) {
+    if ((gMixer.active() || hal::Speaker.isPlaying()) && (int32_t)(hal::millis() - gRecBeepDeadlineMs) < 0) {
+      hal::delay(1);
+      return;
+    }
 
     // Start recording only if the button is still held.
-    if (M5.BtnB.isPressed()) {
+    if (hal::BtnB.isPressed()) {
+      // IMPORTANT: enabling the mic reconfigures the ES8311 and will break audio output
+      // until the speaker is re-initialized. The speaker drains and is ended first; loop()
+      // keeps running (and polls gAudio) until the mic owns the codec.
+      gMixer.stopAll();
+      if (!gAudio.requestMic()) {
+        hal::delay(1);
+        return;
+      }
+      gRecBeepPending = false;
       gRecSamples = 0;
+      gRecClipRateHz = kRecRatesHz[gRecRateIndex];
+      updateRecLimits();
+      gRecWave.reset();
+      gRecDenoiser.configure(gRecClipRateHz);
+      gRecDenoiser.reset();
+      gRecConditioner.configure(gRecClipRateHz);
+      gRecVad.reset();
+      gRecTrimmer.configure(gRecClipRateHz, kRecChunkSamples);
+      gRecOrigSamples = 0;
       gRecActive = true;
       gRecReadyWaitRelease = false;
-      gRecAdpcm.clear();
-      gRecStartMs = millis();
+      gLoadedClipId = 0;
+      gRecStartMs = hal::millis();
       gUiMode = UiMode::Recording;
 
-      Serial.println("[rec] START");
+      hal::logf("[rec] START\n");
+    } else {
+      // Tapped and released during the beep (or the drain): select the next clip. The mic was
+      // never requested, so the speaker stays as it is.
+      gRecBeepPending = false;
+      gTrace.mark(LatencyTrace::Stage::Cancel, hal::micros(), LatencyTrace::Path::RecStart);
+      selectNextClip();
+      gUiMode = UiMode::Normal;
+      gRenderGov.wake(hal::millis());
     }
   }
 
   // Recording loop (runs in small chunks, capped to 3 seconds).
   if (gRecActive) {
     // Record in chunks. We intentionally do not redraw the screen here to reduce CPU load.
-    const bool pressed = M5.BtnB.isPressed();
+    const bool pressed = hal::BtnB.isPressed();
     const bool atMax = (gRecSamples >= gRecMaxSamples);
 
     if (!pressed || atMax) {
+      if (!pressed) {
+        gTrace.mark(LatencyTrace::Stage::ButtonEdge, hal::BtnB.edgeUs(), LatencyTrace::Path::PlayStart);
+      }
       gRecActive = false;
       gRecReadyWaitRelease = pressed; // if user still holds, wait for release before playback.
 
@@ -929,16 +1606,26 @@ void loop() {
         gUiMode = UiMode::Normal;
       }
 
-      Serial.printf("[rec] STOP samples=%u\n", (unsigned)gRecSamples);
+      if (gRecTrimSilence) {
+        bool rewritten = false;
+        const size_t trimmed = gRecTrimmer.finish(gRecPcm, gRecSamples, &rewritten);
+        if (rewritten) {
+          gRecWave.rebuild(gRecPcm, trimmed);
+        }
+        gRecSamples = trimmed;
+      }
+
+      hal::logf("[rec] STOP samples=%u orig=%u (%.2fs -> %.2fs) agc=%+.1fdB noise=%.1fdBFS\n", (unsigned)gRecSamples, (unsigned)gRecOrigSamples, (float)gRecOrigSamples / (float)gRecClipRateHz, (float)gRecSamples / (float)gRecClipRateHz, gRecCondition ? gRecConditioner.lastGainDb() : 0.0f, gRecDenoise ? gRecDenoiser.noiseDbfs() : -99.9f);
+
+      storeTake();
 
       // Stop mic and restore speaker right away so playback / beeps work again.
-      ensureMicOff();
-      ensureSpeakerOn();
+      (void)gAudio.requestSpeaker();
 
       // If already released, playback immediately.
       if (!gRecReadyWaitRelease) {
         (void)startPlayback();
-        lastDrawMs = 0;
+        gRenderGov.wake(hal::millis());
       }
     } else {
       const size_t remain = gRecMaxSamples - gRecSamples;
@@ -946,27 +1633,30 @@ void loop() {
 
       // Enqueue a chunk, then wait until it's filled.
       if (chunk > 0) {
-        const bool ok = M5.Mic.record(gRecPcm + gRecSamples, chunk, kRecSampleRateHz, false);
+        const bool firstChunk = (gRecOrigSamples == 0);
+        const bool ok = hal::Mic.record(gRecPcm + gRecSamples, chunk, gRecClipRateHz);
+        if (firstChunk) {
+          gTrace.mark(LatencyTrace::Stage::MicRecord, hal::micros());
+        }
         if (!ok) {
-          Serial.println("[rec] ERROR: M5.Mic.record failed");
+          hal::logf("[rec] ERROR: hal::Mic.record failed\n");
           gRecActive = false;
           gRecReadyWaitRelease = false;
           gUiMode = UiMode::Error;
           gLastError = "Mic.record failed";
-          ensureMicOff();
-          ensureSpeakerOn();
-          playToneIfEnabled(220.0f, 120, false);
-          delay(1);
+          (void)gAudio.requestSpeaker();
+          playUiTone(220.0f, 120, AudioMixer::Wave::Soft);
+          hal::delay(1);
           return;
         }
-        while (M5.Mic.isRecording()) {
-          M5.update();
+        while (hal::Mic.isRecording()) {
+          hal::update();
 
           // Update REC screen at low rate while we wait.
-          const uint32_t now = millis();
+          const uint32_t now = hal::millis();
           if (shouldDrawStatus(now, 120)) {
             const uint32_t elapsed = now - gRecStartMs;
-            const uint32_t remainMs = (elapsed >= gRecMaxMs) ? 0 : (gRecMaxMs - elapsed);
+            const uint32_t remainMs = (uint32_t)(((uint64_t)(gRecMaxSamples - gRecSamples) * 1000ull) / gRecClipRateHz);
             char l1[64];
             char l2[64];
             snprintf(l1, sizeof(l1), "REC  %lu.%02lus / %lus  samp:%u  left:%lums", (unsigned long)(elapsed / 1000), (unsigned long)((elapsed % 1000) / 10), (unsigned long)(gRecMaxMs / 1000), (unsigned)gRecSamples, (unsigned long)remainMs);
@@ -977,88 +1667,104 @@ void loop() {
             }
             drawStatusScreen("RECORDING", l1, l2, TFT_RED, gRecSpectrum, kRecSpectrumBins);
           }
-          delay(1);
+          hal::delay(1);
         }
 
         // Chunk has finished recording into gRecPcm[gRecSamples..gRecSamples+chunk).
-        // Update spectrum from the recorded audio (avoid reading the buffer mid-write).
+        if (firstChunk) {
+          // Its first sample was captured one chunk-length before the chunk completed; with
+          // denoise on it reaches the take kLatencySamples later, behind the suppressor's delay.
+          const size_t lagSamples = gRecDenoise ? NoiseSuppressor::kLatencySamples : 0;
+          gTrace.mark(LatencyTrace::Stage::FirstCapture, hal::micros() - (uint32_t)(((uint64_t)chunk * 1000000u) / gRecClipRateHz) + (uint32_t)(((uint64_t)lagSamples * 1000000u) / gRecClipRateHz));
+        }
+        // Denoise and condition it in place, then update spectrum/metrics from the result (avoid reading the buffer mid-write).
+        if (gRecDenoise) {
+          gRecDenoiser.process(gRecPcm + gRecSamples, chunk);
+        }
+        if (gRecCondition) {
+          gRecConditioner.process(gRecPcm + gRecSamples, chunk);
+        }
         computeSpectrumFromPcmWindow(gRecPcm + gRecSamples, chunk, chunk);
         computeAudioMetricsFromPcmWindow(gRecPcm + gRecSamples, chunk, chunk);
-        gRecSamples += chunk;
+        if (gRecCondition && gRecMetricsValid) {
+          gRecConditioner.updateAgc(gRecRmsDbfs, gRecPeakDbfs, gRecClipPercent);
+        }
+
+        size_t next = gRecSamples + chunk;
+        bool rewritten = false;
+        if (gRecTrimSilence) {
+          const bool speech = gRecVad.update(gRecRmsDbfs, gRecSpectrum, kRecSpectrumBins);
+          next = gRecTrimmer.commit(gRecPcm, gRecSamples, chunk, speech, &rewritten);
+        }
+        if (rewritten) {
+          gRecWave.rebuild(gRecPcm, next);
+        } else if (next > gRecSamples) {
+          gRecWave.append(gRecPcm + gRecSamples, next - gRecSamples);
+        }
+        gRecOrigSamples += chunk;
+        gRecSamples = next;
       }
-      delay(1);
+      hal::delay(1);
     }
     return;
   }
 
   // If we hit max duration while still holding, wait for KEY2 release to playback.
   if (gRecReadyWaitRelease) {
-    const uint32_t now = millis();
+    const uint32_t now = hal::millis();
     if (shouldDrawStatus(now, 120)) {
       char l1[64];
       char l2[64];
       snprintf(l1, sizeof(l1), "MAX %lus reached", (unsigned long)(gRecMaxMs / 1000));
       snprintf(l2, sizeof(l2), "RELEASE KEY2 to play (%u samples)", (unsigned)gRecSamples);
-      drawStatusScreen("HOLD", l1, l2, TFT_YELLOW);
+      drawStatusScreen("HOLD", l1, l2, TFT_YELLOW, nullptr, 0, &gRecWave);
     }
-    if (M5.BtnB.wasReleased()) {
+    if (hal::BtnB.wasReleased()) {
+      gTrace.mark(LatencyTrace::Stage::ButtonEdge, hal::BtnB.edgeUs(), LatencyTrace::Path::PlayStart);
       gRecReadyWaitRelease = false;
 
       // Restore speaker before playback.
-      ensureMicOff();
-      ensureSpeakerOn();
+      (void)gAudio.requestSpeaker();
 
       (void)startPlayback();
-      lastDrawMs = 0;
+      gRenderGov.wake(hal::millis());
     }
 
     // Stay on the HOLD/PLAY UI; don't fall through to normal rendering.
-    delay(1);
+    hal::delay(1);
     return;
   }
 
   if (gUiMode == UiMode::Error) {
-    const uint32_t now = millis();
+    const uint32_t now = hal::millis();
     if (shouldDrawStatus(now, 200)) {
       drawStatusScreen("ERROR", gLastError ? gLastError : "unknown", "Check MIC enable / wiring", TFT_RED);
     }
-    delay(1);
+    hal::delay(1);
     return;
   }
 
-  // Normal UI uses portrait.
-  static uint32_t lastFrameMs = 0;
-  static float lastAx = 999.0f;
-  static float lastAy = 999.0f;
-  static float lastAz = 999.0f;
-  const uint32_t now = millis();
-  if (now - lastFrameMs < 33) {
-    delay(1);
+  // Normal UI uses portrait. The governor paces wakeups and decides when a frame is needed;
+  // the text key covers the uptime/battery row.
+  const uint32_t now = hal::millis();
+  if (!gRenderGov.due(now)) {
+    idleUntilNextFrame();
     return;
   }
-  lastFrameMs = now;
 
+  const uint32_t textKey = (now / 1000u) * 16u + (gSensors.revision() & 15u);
   if (imuOk) {
     float ax = 0.0f, ay = 0.0f, az = 0.0f;
-    (void)M5.Imu.update();
-    (void)M5.Imu.getAccel(&ax, &ay, &az);
-
-    const bool changed = (fabsf(ax - lastAx) + fabsf(ay - lastAy) + fabsf(az - lastAz)) > 0.02f;
-    const bool timeRefresh = (now - lastDrawMs) > 200;
-    if (changed || timeRefresh) {
-      lastAx = ax;
-      lastAy = ay;
-      lastAz = az;
-      lastDrawMs = now;
-      drawAxesScreen(ax, ay, az);
-    }
-  } else {
-    const bool timeRefresh = (now - lastDrawMs) > 500;
-    if (timeRefresh) {
-      lastDrawMs = now;
-      drawImuDisabledScreen();
+    (void)hal::Imu.update();
+    (void)hal::Imu.getAccel(&ax, &ay, &az);
+    gAccel.update(ax, ay, az, now);
+    // Keep drawing while the filtered/gravity arrows catch up after motion stops.
+    if (gRenderGov.update(now, ax, ay, az, textKey) || gAccel.settling()) {
+      drawAxesScreen();
     }
+  } else if (gRenderGov.update(now, 0.0f, 0.0f, 0.0f, 0)) {
+    drawImuDisabledScreen();
   }
 
-  delay(1);
+  idleUntilNextFrame();
 }
@@ -0,0 +1,293 @@
+#include "mixer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr int kTableBits = 8;
+constexpr size_t kTableSize = (size_t)1 << kTableBits;
+constexpr int32_t kEnvFull = 1 << 23;
+constexpr uint16_t kUnityGain = 32768;
+
+// One guard entry so the interpolator never wraps inside the inner loop.
+int16_t gTables[2][kTableSize + 1];
+bool gTablesReady = false;
+
+void buildTables() {
+  if (gTablesReady) {
+    return;
+  }
+  const float kTwoPi = 6.28318530718f;
+  // sin(x) + sin(3x)/3 peaks at 2*sqrt(2)/3 (x = pi/4); normalize to full scale.
+  const float softScale = 32767.0f * 3.0f / (2.0f * sqrtf(2.0f));
+  for (size_t i = 0; i <= kTableSize; ++i) {
+    const float ph = kTwoPi * (float)(i % kTableSize) / (float)kTableSize;
+    gTables[0][i] = (int16_t)lrintf(32767.0f * sinf(ph));
+    gTables[1][i] = (int16_t)std::max(-32767L, std::min(32767L, lrintf(softScale * (sinf(ph) + sinf(3.0f * ph) / 3.0f))));
+  }
+  gTablesReady = true;
+}
+
+int16_t saturate16(int32_t v) {
+  if (v > 32767) return 32767;
+  if (v < -32768) return -32768;
+  return (int16_t)v;
+}
+
+}  // namespace
+
+void AudioMixer::setSampleRate(uint32_t hz) {
+  if (hz == 0 || hz == rateHz_) {
+    return;
+  }
+  const uint32_t old = rateHz_;
+  rateHz_ = hz;
+  // Keep pitch and the remaining envelope time of sounding voices.
+  for (size_t i = 0; i < kMaxVoices; ++i) {
+    Voice& v = voices_[i];
+    if ((activeMask_ & (1u << i)) == 0 || v.kind != Kind::Tone) {
+      continue;
+    }
+    v.inc = (uint32_t)((double)v.hz * 4294967296.0 / (double)hz);
+    v.holdSamples = (uint32_t)(((uint64_t)v.holdSamples * hz) / old);
+    if (v.stageLeft > 0) {
+      const int32_t target = v.env + v.envStep * (int32_t)v.stageLeft;
+      v.stageLeft = std::max<uint32_t>(1, (uint32_t)(((uint64_t)v.stageLeft * hz) / old));
+      v.envStep = (target - v.env) / (int32_t)v.stageLeft;
+    }
+  }
+}
+
+uint32_t AudioMixer::msToSamples(uint32_t ms) const {
+  return (uint32_t)(((uint64_t)ms * rateHz_) / 1000u);
+}
+
+int AudioMixer::allocVoice() {
+  for (size_t i = 0; i < kMaxVoices; ++i) {
+    if ((activeMask_ & (1u << i)) == 0) {
+      return (int)i;
+    }
+  }
+  // Full: steal the oldest tone (UI sounds are short; the newest one is what the user did).
+  int oldest = -1;
+  for (size_t i = 0; i < kMaxVoices; ++i) {
+    if (voices_[i].kind == Kind::Tone && (oldest < 0 || (int32_t)(voices_[i].serial - voices_[oldest].serial) < 0)) {
+      oldest = (int)i;
+    }
+  }
+  return oldest;
+}
+
+int AudioMixer::playTone(float hz, uint32_t ms, uint16_t gainQ15, const Envelope& env, Wave wave, uint32_t nowUs) {
+  if (hz <= 0.0f || hz * 2.0f >= (float)rateHz_ || gainQ15 == 0) {
+    return -1;
+  }
+  buildTables();
+  const int idx = allocVoice();
+  if (idx < 0) {
+    return -1;
+  }
+  Voice& v = voices_[idx];
+  v = Voice();
+  v.kind = Kind::Tone;
+  v.wave = wave;
+  v.hz = hz;
+  v.inc = (uint32_t)((double)hz * 4294967296.0 / (double)rateHz_);
+  v.shape = env;
+  v.gainQ15 = gainQ15;
+  // Note-on length covers attack + decay + sustain; release runs after it.
+  const uint32_t ad = (uint32_t)env.attackMs + env.decayMs;
+  v.holdSamples = (ms > ad) ? msToSamples(ms - ad) : 0;
+  v.triggerUs = nowUs;
+  v.serial = ++serial_;
+  v.pendingStart = true;
+  enterStage(v, Stage::Attack);
+  activeMask_ |= 1u << idx;
+  return idx;
+}
+
+int AudioMixer::playStream(PullFn pull, uint16_t gainQ15, uint32_t nowUs) {
+  if (pull == nullptr) {
+    return -1;
+  }
+  // One stream at a time: a new clip replaces the old one.
+  int idx = -1;
+  for (size_t i = 0; i < kMaxVoices; ++i) {
+    if ((activeMask_ & (1u << i)) != 0 && voices_[i].kind == Kind::Stream) {
+      idx = (int)i;
+      break;
+    }
+  }
+  if (idx < 0) {
+    idx = allocVoice();
+  }
+  if (idx < 0) {
+    return -1;
+  }
+  Voice& v = voices_[idx];
+  v = Voice();
+  v.kind = Kind::Stream;
+  v.stage = Stage::Sustain;
+  v.pull = pull;
+  v.gainQ15 = gainQ15;
+  v.triggerUs = nowUs;
+  v.serial = ++serial_;
+  v.pendingStart = true;
+  activeMask_ |= 1u << idx;
+  return idx;
+}
+
+void AudioMixer::stopAll() {
+  for (Voice& v : voices_) {
+    v.stage = Stage::Done;
+  }
+  activeMask_ = 0;
+}
+
+bool AudioMixer::streamActive() const {
+  for (size_t i = 0; i < kMaxVoices; ++i) {
+    if ((activeMask_ & (1u << i)) != 0 && voices_[i].kind == Kind::Stream) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void AudioMixer::enterStage(Voice& v, Stage stage) {
+  // Zero-length stages are skipped; the envelope lands exactly on each stage target.
+  for (;;) {
+    v.stage = stage;
+    int32_t target = 0;
+    uint32_t len = 0;
+    switch (stage) {
+      case Stage::Attack:
+        target = kEnvFull;
+        len = msToSamples(v.shape.attackMs);
+        break;
+      case Stage::Decay:
+        target = (int32_t)std::min<uint32_t>(v.shape.sustainQ15, 32768) << 8;
+        len = msToSamples(v.shape.decayMs);
+        break;
+      case Stage::Sustain:
+        target = v.env;
+        len = v.holdSamples;
+        break;
+      case Stage::Release:
+        target = 0;
+        len = msToSamples(v.shape.releaseMs);
+        break;
+      default:
+        v.env = 0;
+        v.envStep = 0;
+        v.stageLeft = 0;
+        return;
+    }
+    if (len > 0) {
+      v.stageLeft = len;
+      v.envStep = (target - v.env) / (int32_t)len;
+      return;
+    }
+    v.env = target;
+    stage = (Stage)((uint8_t)stage + 1);
+  }
+}
+
+size_t AudioMixer::renderTone(Voice& v, int32_t* acc, size_t n) {
+  const int16_t* table = gTables[(size_t)v.wave];
+  const int32_t gain = v.gainQ15;
+  size_t pos = 0;
+  while (pos < n && v.stage != Stage::Done) {
+    const size_t seg = std::min<size_t>(n - pos, v.stageLeft);
+    uint32_t phase = v.phase;
+    const uint32_t inc = v.inc;
+    int32_t env = v.env;
+    const int32_t step = v.envStep;
+    int32_t* dst = acc + pos;
+    for (size_t k = 0; k < seg; ++k) {
+      const uint32_t i = phase >> (32 - kTableBits);
+      const int32_t frac = (int32_t)((phase >> (17 - kTableBits)) & 0x7FFF);
+      const int32_t a = table[i];
+      const int32_t s = a + (((table[i + 1] - a) * frac) >> 15);
+      const int32_t amp = ((env >> 8) * gain) >> 15;
+      dst[k] += (s * amp) >> 15;
+      phase += inc;
+      env += step;
+    }
+    v.phase = phase;
+    v.env = env;
+    v.stageLeft -= (uint32_t)seg;
+    pos += seg;
+    if (v.stageLeft == 0) {
+      // Snap to the stage target (integer steps leave a small remainder).
+      switch (v.stage) {
+        case Stage::Attack: v.env = kEnvFull; break;
+        case Stage::Decay: v.env = (int32_t)std::min<uint32_t>(v.shape.sustainQ15, 32768) << 8; break;
+        case Stage::Release: v.env = 0; break;
+        default: break;
+      }
+      enterStage(v, (Stage)((uint8_t)v.stage + 1));
+    }
+  }
+  return pos;
+}
+
+size_t AudioMixer::renderStream(Voice& v, int32_t* acc, size_t n) {
+  const size_t got = std::min(n, v.pull(scratch_, n));
+  if (v.gainQ15 >= kUnityGain) {
+    for (size_t k = 0; k < got; ++k) {
+      acc[k] += scratch_[k];
+    }
+  } else {
+    const int32_t gain = v.gainQ15;
+    for (size_t k = 0; k < got; ++k) {
+      acc[k] += (scratch_[k] * gain) >> 15;
+    }
+  }
+  if (got < n) {
+    v.stage = Stage::Done;
+  }
+  return got;
+}
+
+void AudioMixer::noteStart(Voice& v, size_t offset, uint32_t blockStartUs) {
+  v.pendingStart = false;
+  const uint32_t atUs = blockStartUs + (uint32_t)(((uint64_t)offset * 1000000u) / rateHz_);
+  const int32_t lat = (int32_t)(atUs - v.triggerUs);
+  const uint32_t us = (lat > 0) ? (uint32_t)lat : 0;
+  ++latency_.count;
+  latency_.lastUs = us;
+  latency_.maxUs = std::max(latency_.maxUs, us);
+  latency_.sumUs += us;
+}
+
+size_t AudioMixer::render(int16_t* out, size_t n, uint32_t blockStartUs) {
+  if (activeMask_ == 0 || out == nullptr) {
+    return 0;
+  }
+  n = std::min(n, kMaxBlockSamples);
+  memset(acc_, 0, n * sizeof(acc_[0]));
+
+  size_t end = 0;
+  for (size_t i = 0; i < kMaxVoices; ++i) {
+    if ((activeMask_ & (1u << i)) == 0) {
+      continue;
+    }
+    Voice& v = voices_[i];
+    if (v.pendingStart) {
+      noteStart(v, 0, blockStartUs);
+    }
+    const size_t produced = (v.kind == Kind::Tone) ? renderTone(v, acc_, n) : renderStream(v, acc_, n);
+    end = std::max(end, produced);
+    if (v.stage == Stage::Done) {
+      activeMask_ &= ~(1u << i);
+    }
+  }
+
+  const size_t used = (activeMask_ != 0) ? n : end;
+  for (size_t k = 0; k < used; ++k) {
+    out[k] = saturate16(acc_[k]);
+  }
+  return used;
+}
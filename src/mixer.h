@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Block mixer for the speaker stream: wavetable tone voices with ADSR envelopes (UI sounds)
+// plus one pull-based stream voice (clip playback). The caller renders a block whenever the
+// speaker queue has room, so sounds overlap and nothing waits on the speaker.
+//
+// Kernel: int32 accumulator per block; tones use a 256-entry Q15 table with linear
+// interpolation and a Q32 phase accumulator, the envelope is piecewise linear in Q23 and each
+// stage runs as a branch-free inner loop. The output rate can change between blocks (it
+// follows the clip rate); pitch and envelope timing are rescaled for active voices.
+//
+// Start-of-sound latency: each voice remembers its trigger time; render() is told when the
+// block will reach the speaker, so trigger -> first audible sample is known per sound.
+class AudioMixer {
+ public:
+  static constexpr size_t kMaxVoices = 8;
+  static constexpr size_t kMaxBlockSamples = 1024;
+
+  enum class Wave : uint8_t {
+    Sine = 0,
+    Soft,  // sine + 1/3 third harmonic: carries better on the small speaker
+  };
+
+  struct Envelope {
+    uint16_t attackMs;
+    uint16_t decayMs;
+    uint16_t sustainQ15;
+    uint16_t releaseMs;
+  };
+
+  // Fills up to cap samples at the mixer rate; fewer than cap ends the stream.
+  typedef size_t (*PullFn)(int16_t* out, size_t cap);
+
+  struct LatencyStats {
+    uint32_t count = 0;
+    uint32_t lastUs = 0;
+    uint32_t maxUs = 0;
+    uint64_t sumUs = 0;
+  };
+
+  void setSampleRate(uint32_t hz);
+  uint32_t sampleRate() const { return rateHz_; }
+
+  // Returns the voice index, or -1 if the mixer is full. A full mixer steals the oldest tone.
+  int playTone(float hz, uint32_t ms, uint16_t gainQ15, const Envelope& env, Wave wave, uint32_t nowUs);
+  int playStream(PullFn pull, uint16_t gainQ15, uint32_t nowUs);
+  void stopAll();
+
+  bool active() const { return activeMask_ != 0; }
+  bool streamActive() const;
+
+  // Mixes all voices into out[0..n) and returns the number of samples worth sending (n while
+  // any voice is sounding, less when the last one ends inside the block, 0 when idle).
+  // blockStartUs is when out[0] will reach the speaker.
+  size_t render(int16_t* out, size_t n, uint32_t blockStartUs);
+
+  const LatencyStats& latency() const { return latency_; }
+  void resetLatency() { latency_ = LatencyStats(); }
+
+ private:
+  enum class Kind : uint8_t {
+    Tone = 0,
+    Stream,
+  };
+  enum class Stage : uint8_t {
+    Attack = 0,
+    Decay,
+    Sustain,
+    Release,
+    Done,
+  };
+
+  struct Voice {
+    Kind kind = Kind::Tone;
+    Wave wave = Wave::Sine;
+    Stage stage = Stage::Done;
+    bool pendingStart = false;
+    float hz = 0.0f;
+    uint32_t phase = 0;
+    uint32_t inc = 0;
+    int32_t env = 0;        // Q23
+    int32_t envStep = 0;    // per sample
+    uint32_t stageLeft = 0; // samples
+    uint32_t holdSamples = 0;
+    Envelope shape = {0, 0, 0, 0};
+    uint16_t gainQ15 = 0;
+    uint32_t triggerUs = 0;
+    uint32_t serial = 0;
+    PullFn pull = nullptr;
+  };
+
+  int allocVoice();
+  void enterStage(Voice& v, Stage stage);
+  uint32_t msToSamples(uint32_t ms) const;
+  size_t renderTone(Voice& v, int32_t* acc, size_t n);
+  size_t renderStream(Voice& v, int32_t* acc, size_t n);
+  void noteStart(Voice& v, size_t offset, uint32_t blockStartUs);
+
+  Voice voices_[kMaxVoices];
+  uint32_t activeMask_ = 0;
+  uint32_t rateHz_ = 16000;
+  uint32_t serial_ = 0;
+  LatencyStats latency_;
+  int32_t acc_[kMaxBlockSamples];
+  int16_t scratch_[kMaxBlockSamples];
+};
@@ -0,0 +1,84 @@
+#include "render_governor.h"
+
+#include <cmath>
+
+void RenderGovernor::reset(uint32_t nowMs) {
+  tier_ = Tier::Active;
+  force_ = true;
+  nextWakeMs_ = nowMs;
+  lastMotionMs_ = nowMs;
+  textKey_ = 0;
+}
+
+void RenderGovernor::wake(uint32_t nowMs) {
+  tier_ = Tier::Active;
+  force_ = true;
+  lastMotionMs_ = nowMs;
+  nextWakeMs_ = nowMs;
+}
+
+bool RenderGovernor::update(uint32_t nowMs, float ax, float ay, float az, uint32_t textKey) {
+  const bool moved = (fabsf(ax - ax_) + fabsf(ay - ay_) + fabsf(az - az_)) > kMotionThreshold;
+  if (moved) {
+    lastMotionMs_ = nowMs;
+    tier_ = Tier::Active;
+  } else if (tier_ == Tier::Active && (nowMs - lastMotionMs_) >= kIdleAfterMs) {
+    tier_ = Tier::Idle;
+  }
+
+  const bool draw = force_ || moved || (textKey != textKey_);
+  if (draw) {
+    force_ = false;
+    textKey_ = textKey;
+    ax_ = ax;
+    ay_ = ay;
+    az_ = az;
+  }
+
+  // Fixed cadence from the previous deadline; resync if we fell behind (e.g. a slow push).
+  const uint32_t period = (tier_ == Tier::Active) ? kActiveFrameMs : kIdlePollMs;
+  nextWakeMs_ += period;
+  if ((int32_t)(nowMs - nextWakeMs_) >= 0) {
+    nextWakeMs_ = nowMs + period;
+  }
+  return draw;
+}
+
+void LoopRateStats::wake(uint8_t mode, uint32_t nowMs) {
+  if (mode >= kMaxModes) {
+    return;
+  }
+  if (!started_) {
+    started_ = true;
+    windowStartMs_ = nowMs;
+  } else {
+    modeMs_[lastMode_] += nowMs - lastWakeMs_;
+  }
+  lastWakeMs_ = nowMs;
+  lastMode_ = mode;
+  ++wakes_[mode];
+}
+
+void LoopRateStats::frame(uint8_t mode) {
+  if (mode < kMaxModes) {
+    ++frames_[mode];
+  }
+}
+
+bool LoopRateStats::roll(uint32_t nowMs) {
+  const uint32_t elapsed = nowMs - windowStartMs_;
+  if (!started_ || elapsed < kWindowMs) {
+    return false;
+  }
+  for (size_t m = 0; m < kMaxModes; ++m) {
+    const float sec = (float)modeMs_[m] / 1000.0f;
+    wakeRate_[m] = (sec > 0.0f) ? (float)wakes_[m] / sec : 0.0f;
+    frameRate_[m] = (sec > 0.0f) ? (float)frames_[m] / sec : 0.0f;
+    share_[m] = (float)modeMs_[m] / (float)elapsed;
+    wakes_[m] = 0;
+    frames_[m] = 0;
+    modeMs_[m] = 0;
+  }
+  windowStartMs_ = nowMs;
+  return true;
+}
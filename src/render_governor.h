@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Adaptive wake/render pacing for the axes screen. Pure logic on an explicit clock
+// (nowMs is passed in), so it runs unchanged against the simulator or a bench clock.
+//
+//   Active: wake every 16 ms (~60 fps) and draw when the tilt or the status text changed.
+//   Idle:   after 1.5 s without motion, wake every 50 ms only to poll IMU/buttons (the caller
+//           may light-sleep in between) and draw only when the status text changes, i.e.
+//           once per second for the uptime clock.
+//
+// Motion beyond the threshold or wake() (button edge, background change, mode switch)
+// returns to Active immediately; wake() also forces the next update() to draw.
+class RenderGovernor {
+ public:
+  enum class Tier : uint8_t {
+    Active = 0,
+    Idle,
+  };
+
+  static constexpr uint32_t kActiveFrameMs = 16;
+  static constexpr uint32_t kIdlePollMs = 50;
+  static constexpr uint32_t kIdleAfterMs = 1500;
+  static constexpr float kMotionThreshold = 0.02f;  // |dax|+|day|+|daz| in g since the last frame
+
+  void reset(uint32_t nowMs);
+  void wake(uint32_t nowMs);
+
+  bool due(uint32_t nowMs) const { return (int32_t)(nowMs - nextWakeMs_) >= 0; }
+  uint32_t nextWakeMs() const { return nextWakeMs_; }
+  Tier tier() const { return tier_; }
+
+  // One scheduled wakeup with a fresh accel sample and a key of the non-IMU text on screen.
+  // Returns true when a frame should be drawn.
+  bool update(uint32_t nowMs, float ax, float ay, float az, uint32_t textKey);
+
+ private:
+  Tier tier_ = Tier::Active;
+  bool force_ = true;
+  uint32_t nextWakeMs_ = 0;
+  uint32_t lastMotionMs_ = 0;
+  uint32_t textKey_ = 0;
+  float ax_ = 0.0f;
+  float ay_ = 0.0f;
+  float az_ = 0.0f;
+};
+
+// Wakeups and frames per second per loop mode, over fixed windows. Rates are per second
+// spent in the mode (time between wakeups is charged to the mode of the earlier one).
+class LoopRateStats {
+ public:
+  static constexpr size_t kMaxModes = 10;
+  static constexpr uint32_t kWindowMs = 10000;
+
+  void wake(uint8_t mode, uint32_t nowMs);
+  void frame(uint8_t mode);
+
+  // Closes the window once kWindowMs has elapsed; returns true when new rates are available.
+  bool roll(uint32_t nowMs);
+
+  float wakesPerSec(uint8_t mode) const { return (mode < kMaxModes) ? wakeRate_[mode] : 0.0f; }
+  float framesPerSec(uint8_t mode) const { return (mode < kMaxModes) ? frameRate_[mode] : 0.0f; }
+  float timeShare(uint8_t mode) const { return (mode < kMaxModes) ? share_[mode] : 0.0f; }
+
+ private:
+  uint32_t windowStartMs_ = 0;
+  uint32_t lastWakeMs_ = 0;
+  uint8_t lastMode_ = 0;
+  bool started_ = false;
+  uint32_t wakes_[kMaxModes] = {0};
+  uint32_t frames_[kMaxModes] = {0};
+  uint32_t modeMs_[kMaxModes] = {0};
+  float wakeRate_[kMaxModes] = {0};
+  float frameRate_[kMaxModes] = {0};
+  float share_[kMaxModes] = {0};
+};
@@ -0,0 +1,188 @@
+#include "resampler.h"
+
+#include <cmath>
+
+namespace {
+
+constexpr float kPi = 3.14159265358979f;
+constexpr uint32_t kPhaseShift = 16 - 7;  // Q16 fraction -> 128 phases
+static_assert((1u << (16 - kPhaseShift)) == PolyphaseResampler::kPhases, "phase shift must match kPhases");
+
+int16_t sat16(int32_t v) {
+  if (v > 32767) return 32767;
+  if (v < -32768) return -32768;
+  return (int16_t)v;
+}
+
+}  // namespace
+
+bool PolyphaseResampler::configure(float inPerOut) {
+  if (!(inPerOut > 0.0f) || inPerOut > 8.0f) {
+    return false;
+  }
+  step_ = (uint32_t)lroundf(inPerOut * 65536.0f);
+
+  // Anti-alias/anti-image cutoff relative to the input rate, 10% guard band.
+  const float cutoff = 0.45f * ((inPerOut > 1.0f) ? (1.0f / inPerOut) : 1.0f);
+  if (cutoff != cutoff_) {
+    designFilters(cutoff);
+  }
+  return true;
+}
+
+bool PolyphaseResampler::configureRates(uint32_t inRateHz, uint32_t outRateHz) {
+  if (inRateHz == 0 || outRateHz == 0) {
+    return false;
+  }
+  if (!configure((float)inRateHz / (float)outRateHz)) {
+    return false;
+  }
+  step_ = (uint32_t)(((uint64_t)inRateHz << 16) / outRateHz);
+  return true;
+}
+
+void PolyphaseResampler::designFilters(float cutoff) {
+  cutoff_ = cutoff;
+  const float half = (float)kTaps * 0.5f;
+  for (size_t p = 0; p < kPhases; ++p) {
+    // Output time inside the history window, x[0] oldest .. x[kTaps-1] newest.
+    const float t = (half - 1.0f) + (float)p / (float)kPhases;
+    float h[kTaps];
+    float sum = 0.0f;
+    for (size_t k = 0; k < kTaps; ++k) {
+      const float u = t - (float)k;
+      const float arg = 2.0f * cutoff * u;
+      const float sinc = (fabsf(arg) < 1e-6f) ? 1.0f : sinf(kPi * arg) / (kPi * arg);
+      const float w = 0.42f + 0.5f * cosf(2.0f * kPi * u / (float)kTaps) + 0.08f * cosf(4.0f * kPi * u / (float)kTaps);
+      h[k] = sinc * ((w > 0.0f) ? w : 0.0f);
+      sum += h[k];
+    }
+    // Unity DC gain per phase so a constant input stays constant.
+    const float norm = (sum != 0.0f) ? (1.0f / sum) : 0.0f;
+    for (size_t k = 0; k < kTaps; ++k) {
+      coeffs_[p][k] = sat16((int32_t)lroundf(h[k] * norm * 32768.0f));
+    }
+  }
+}
+
+void PolyphaseResampler::reset() {
+  for (size_t i = 0; i < kTaps * 2; ++i) {
+    hist_[i] = 0;
+  }
+  histPos_ = 0;
+  frac_ = 0;
+  need_ = 0;
+}
+
+void PolyphaseResampler::push(int16_t s) {
+  hist_[histPos_] = s;
+  hist_[histPos_ + kTaps] = s;
+  histPos_ = (histPos_ + 1 == kTaps) ? 0 : histPos_ + 1;
+}
+
+size_t PolyphaseResampler::process(const int16_t* in, size_t inCount, int16_t* out, size_t outCap, size_t* consumed) {
+  size_t used = 0;
+  size_t produced = 0;
+  while (produced < outCap) {
+    while (need_ > 0 && used < inCount) {
+      push(in[used++]);
+      --need_;
+    }
+    if (need_ > 0) {
+      break;
+    }
+
+    const int16_t* h = coeffs_[frac_ >> kPhaseShift];
+    const int16_t* x = &hist_[histPos_];
+    int32_t acc = 1 << 14;
+    for (size_t k = 0; k < kTaps; ++k) {
+      acc += (int32_t)h[k] * (int32_t)x[k];
+    }
+    out[produced++] = sat16(acc >> 15);
+
+    frac_ += step_;
+    need_ = frac_ >> 16;
+    frac_ &= 0xFFFFu;
+  }
+  if (consumed != nullptr) {
+    *consumed = used;
+  }
+  return produced;
+}
+
+void TimeStretcher::start(const int16_t* src, size_t samples, uint16_t speedQ8) {
+  src_ = src;
+  samples_ = samples;
+  speedQ8_ = (speedQ8 == 0) ? 256 : speedQ8;
+  analysisQ8_ = 0;
+  cont_ = 0;
+  segPos_ = 0;
+  first_ = true;
+  done_ = (src == nullptr || samples == 0);
+  if (!done_) {
+    beginSegment();
+  }
+}
+
+size_t TimeStretcher::bestOffset(size_t target, size_t cont) const {
+  if (cont + kOverlapSamples > samples_) {
+    return target;
+  }
+
+  // Decimated cross-correlation against the natural continuation; bounded at
+  // (2 * kSearchSamples / 2) * (kOverlapSamples / 4) MACs per segment.
+  size_t best = target;
+  int32_t bestScore = INT32_MIN;
+  const size_t lo = (target > kSearchSamples) ? target - kSearchSamples : 0;
+  const size_t hi = target + kSearchSamples;
+  for (size_t cand = lo; cand <= hi; cand += 2) {
+    if (cand + kOverlapSamples > samples_) {
+      break;
+    }
+    int32_t score = 0;
+    for (size_t i = 0; i < kOverlapSamples; i += 4) {
+      score += ((int32_t)src_[cont + i] * (int32_t)src_[cand + i]) >> 6;
+    }
+    if (score > bestScore) {
+      bestScore = score;
+      best = cand;
+    }
+  }
+  return best;
+}
+
+void TimeStretcher::beginSegment() {
+  const size_t target = analysisQ8_ >> 8;
+  segStart_ = first_ ? target : bestOffset(target, cont_);
+  segPos_ = 0;
+  if (segStart_ >= samples_) {
+    done_ = true;
+  }
+}
+
+size_t TimeStretcher::render(int16_t* out, size_t outCap) {
+  size_t n = 0;
+  while (n < outCap && !done_) {
+    const size_t i = segStart_ + segPos_;
+    int32_t v = (i < samples_) ? src_[i] : 0;
+    if (!first_ && segPos_ < kOverlapSamples) {
+      const size_t j = cont_ + segPos_;
+      const int32_t c = (j < samples_) ? src_[j] : 0;
+      const int32_t w = (int32_t)((segPos_ * 32768u) / kOverlapSamples);
+      v = (v * w + c * (32768 - w)) >> 15;
+    }
+    out[n++] = (int16_t)v;
+
+    if (++segPos_ == kHopSamples) {
+      first_ = false;
+      cont_ = segStart_ + kHopSamples;
+      analysisQ8_ += (uint32_t)speedQ8_ * (uint32_t)kHopSamples;
+      if ((analysisQ8_ >> 8) >= samples_) {
+        done_ = true;
+      } else {
+        beginSegment();
+      }
+    }
+  }
+  return n;
+}
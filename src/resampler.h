@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Streaming fixed-point polyphase resampler (int16 in/out, Q15 taps, int32 MAC).
+//
+// The prototype is a Blackman-windowed sinc split into kPhases sub-filters of kTaps taps
+// each. Output positions advance in Q16.16 input samples; the sub-filter is chosen by
+// the top bits of the fractional position (nearest phase). At 128 phases in-band tones
+// keep >50 dB SNR, and 24 taps reject tones above the output Nyquist by ~68 dB (6 kHz at
+// 16k -> 8k; the bench requires >60 dB).
+//
+// Block API: process() consumes as much input and produces as much output as fits, and
+// keeps its history across calls, so callers can feed arbitrary chunk sizes.
+class PolyphaseResampler {
+ public:
+  static constexpr size_t kTaps = 24;
+  static constexpr size_t kPhases = 128;
+
+  // inPerOut: input samples consumed per output sample (e.g. 2.0 for 16k -> 8k, 0.5 for
+  // 2x playback slowdown). Recomputes the sub-filters when the anti-alias cutoff changes.
+  bool configure(float inPerOut);
+  bool configureRates(uint32_t inRateHz, uint32_t outRateHz);
+
+  void reset();
+
+  // Returns the number of output samples written; *consumed receives input samples used.
+  size_t process(const int16_t* in, size_t inCount, int16_t* out, size_t outCap, size_t* consumed);
+
+  uint32_t stepQ16() const { return step_; }
+
+ private:
+  void designFilters(float cutoff);
+  void push(int16_t s);
+
+  int16_t coeffs_[kPhases][kTaps] = {};
+  int16_t hist_[kTaps * 2] = {};  // doubled so the newest kTaps samples are always contiguous
+  size_t histPos_ = 0;
+  uint32_t step_ = 1u << 16;
+  uint32_t frac_ = 0;
+  uint32_t need_ = 0;
+  float cutoff_ = 0.0f;
+};
+
+// Pitch-preserving speed change (WSOLA-style overlap-add) over an in-memory clip.
+//
+// Emits kHopSamples per segment; each segment starts at the analysis position advanced by
+// speed * kHopSamples, nudged by up to +/-kSearchSamples to best match the natural
+// continuation of the previous segment, and cross-faded over kOverlapSamples.
+class TimeStretcher {
+ public:
+  static constexpr size_t kHopSamples = 320;
+  static constexpr size_t kOverlapSamples = 160;
+  static constexpr size_t kSearchSamples = 80;
+
+  // speedQ8: 256 = 1.0x, 128 = 0.5x, 512 = 2.0x.
+  void start(const int16_t* src, size_t samples, uint16_t speedQ8);
+
+  size_t render(int16_t* out, size_t outCap);
+
+  bool done() const { return done_; }
+  size_t sourcePos() const { return segStart_; }
+
+ private:
+  size_t bestOffset(size_t target, size_t cont) const;
+  void beginSegment();
+
+  const int16_t* src_ = nullptr;
+  size_t samples_ = 0;
+  uint32_t analysisQ8_ = 0;  // source position in Q24.8
+  uint16_t speedQ8_ = 256;
+  size_t cont_ = 0;           // natural continuation of the previous segment
+  size_t segStart_ = 0;
+  size_t segPos_ = 0;
+  bool first_ = true;
+  bool done_ = true;
+};
@@ -0,0 +1,107 @@
+#include "sensor_service.h"
+
+#include <cstdlib>
+
+#include "hal.h"
+
+void SlowSensorService::begin(uint32_t nowMs) {
+  for (size_t i = 0; i < kChannelCount; ++i) {
+    readChannel((Channel)i);
+    nextMs_[i] = nowMs + intervalMs_[i];
+  }
+  charging_ = chargeCandidate_;
+}
+
+void SlowSensorService::setInterval(Channel ch, uint32_t ms) {
+  const size_t i = (size_t)ch;
+  if (i >= kChannelCount) {
+    return;
+  }
+  intervalMs_[i] = ms;
+  nextMs_[i] = hal::millis() + ms;
+}
+
+bool SlowSensorService::poll(uint32_t nowMs) {
+  // Most overdue channel only, so a frame never waits on more than one transaction.
+  size_t due = kChannelCount;
+  int32_t lateMost = -1;
+  for (size_t i = 0; i < kChannelCount; ++i) {
+    if (intervalMs_[i] == 0) {
+      continue;
+    }
+    const int32_t late = (int32_t)(nowMs - nextMs_[i]);
+    if (late > lateMost) {
+      lateMost = late;
+      due = i;
+    }
+  }
+  if (due == kChannelCount) {
+    return false;
+  }
+
+  const uint32_t before = revision_;
+  readChannel((Channel)due);
+  nextMs_[due] = nowMs + intervalMs_[due];
+  return revision_ != before;
+}
+
+void SlowSensorService::readChannel(Channel ch) {
+  ++reads_[(size_t)ch];
+  switch (ch) {
+    case Channel::BatteryLevel: {
+      int32_t v = hal::Power.getBatteryLevel();
+      if (v < 0) {
+        if (levelPct_ >= 0) {
+          levelPct_ = -1;
+          ++revision_;
+        }
+        levelQ8_ = -1;
+        return;
+      }
+      if (v > 100) v = 100;
+      if (levelQ8_ < 0) {
+        levelQ8_ = v * 256;
+      } else {
+        levelQ8_ += (v * 256 - levelQ8_) / 4;
+      }
+      // Publish when the smoothed level rounds to a different percent and is at least 0.75 %
+      // away from what is on screen: a settled 1 % step always lands, while an EMA hovering
+      // around a .5 boundary does not flip the footer back and forth.
+      const int rounded = (int)((levelQ8_ + 128) >> 8);
+      const int32_t shownQ8 = levelPct_ * 256;
+      if (levelPct_ < 0 || (rounded != levelPct_ && abs(levelQ8_ - shownQ8) >= 192)) {
+        levelPct_ = rounded;
+        ++revision_;
+      }
+      return;
+    }
+    case Channel::BatteryVoltage: {
+      const int32_t mv = hal::Power.getBatteryVoltage();
+      if (mv <= 0) {
+        if (voltageMv_ > 0) {
+          ++revision_;
+        }
+        voltageMv_ = 0;
+        voltageQ4_ = 0;
+        return;
+      }
+      voltageQ4_ = (voltageQ4_ == 0) ? mv * 16 : voltageQ4_ + (mv * 16 - voltageQ4_) / 4;
+      if (voltageMv_ == 0) {
+        ++revision_;  // validity changed; later voltage drift is not shown, so no bump
+      }
+      voltageMv_ = (int)((voltageQ4_ + 8) >> 4);
+      return;
+    }
+    case Channel::ChargeState: {
+      const bool now = hal::Power.isCharging();
+      if (now == chargeCandidate_ && now != charging_) {
+        charging_ = now;
+        ++revision_;
+      }
+      chargeCandidate_ = now;
+      return;
+    }
+    default:
+      return;
+  }
+}
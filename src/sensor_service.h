@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Cached slow sensors (PMIC battery level/voltage, charge state). The render path only reads
+// the published values; poll() runs from loop() between frames and performs at most one
+// I2C read per call, for the most overdue channel. Cooperative rather than a separate task:
+// the PMIC shares the internal I2C bus with the IMU, so reads stay serialized with
+// hal::Imu.update() without bus locking.
+//
+// Smoothing: voltage is an EMA (1/4 per sample), level is an EMA published when it rounds to a
+// new percent at least 0.75 % from the shown one (no flicker between neighbours, but a steady
+// 1 % change always shows), charge state must read the same twice.
+// Adding a channel (e.g. temperature) = enum entry + default interval + a case in readChannel().
+class SlowSensorService {
+ public:
+  enum class Channel : uint8_t {
+    BatteryLevel = 0,
+    BatteryVoltage,
+    ChargeState,
+    Count,
+  };
+  static constexpr size_t kChannelCount = (size_t)Channel::Count;
+
+  static constexpr uint32_t kDefaultLevelMs = 30000;
+  static constexpr uint32_t kDefaultVoltageMs = 10000;
+  static constexpr uint32_t kDefaultChargeMs = 2000;
+
+  // Reads every channel once so the cache is valid before the first frame.
+  void begin(uint32_t nowMs);
+
+  // 0 disables polling of the channel (the last published value is kept).
+  void setInterval(Channel ch, uint32_t ms);
+  uint32_t interval(Channel ch) const { return intervalMs_[(size_t)ch]; }
+
+  // Returns true if the revision changed.
+  bool poll(uint32_t nowMs);
+
+  bool batteryValid() const { return levelPct_ >= 0 && voltageMv_ > 0; }
+  int batteryLevel() const { return levelPct_; }  // 0..100, -1 unknown
+  int batteryMv() const { return voltageMv_; }    // 0 unknown
+  bool charging() const { return charging_; }
+
+  // Bumped when the battery text could change (level, validity, charge state); a cheap
+  // "status text changed" key for the render governor.
+  uint32_t revision() const { return revision_; }
+  uint32_t reads(Channel ch) const { return reads_[(size_t)ch]; }
+
+ private:
+  void readChannel(Channel ch);
+
+  uint32_t intervalMs_[kChannelCount] = {kDefaultLevelMs, kDefaultVoltageMs, kDefaultChargeMs};
+  uint32_t nextMs_[kChannelCount] = {0};
+  uint32_t reads_[kChannelCount] = {0};
+
+  int32_t levelQ8_ = -1;  // EMA state, percent * 256
+  int32_t voltageQ4_ = 0; // EMA state, mV * 16
+  int levelPct_ = -1;
+  int voltageMv_ = 0;
+  bool charging_ = false;
+  bool chargeCandidate_ = false;
+  uint32_t revision_ = 0;
+};
@@ -0,0 +1,102 @@
+#include "telemetry.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "hal.h"
+
+void Telemetry::begin(uint32_t nowMs) {
+  head_ = 0;
+  count_ = 0;
+  cores_ = (uint8_t)std::min<size_t>(hal::cpuCoreCount(), kMaxCores);
+  for (uint8_t c = 0; c < cores_; ++c) {
+    lastIdleUs_[c] = hal::cpuIdleUs(c);
+  }
+  lastUs_ = hal::micros();
+  nextMs_ = nowMs + kPeriodMs;
+}
+
+bool Telemetry::poll(uint32_t nowMs) {
+  if ((int32_t)(nowMs - nextMs_) < 0) {
+    return false;
+  }
+  take(nowMs);
+  nextMs_ += kPeriodMs;
+  if ((int32_t)(nowMs - nextMs_) >= 0) {
+    nextMs_ = nowMs + kPeriodMs;
+  }
+  return true;
+}
+
+void Telemetry::take(uint32_t nowMs) {
+  Sample& s = ring_[head_];
+  s.tMs = nowMs;
+  s.heapFree = hal::freeHeap();
+  s.heapMin = hal::minFreeHeap();
+  s.heapLargest = hal::largestFreeHeapBlock();
+  s.psramFree = hal::freePsram();
+  s.psramMin = hal::minFreePsram();
+  s.psramLargest = hal::largestFreePsramBlock();
+
+  const uint32_t nowUs = hal::micros();
+  const uint32_t elapsedUs = nowUs - lastUs_;
+  lastUs_ = nowUs;
+  const bool measured = hal::cpuIdleMeasured();
+  for (uint8_t c = 0; c < kMaxCores; ++c) {
+    if (c >= cores_ || elapsedUs == 0) {
+      s.loadPct[c] = 0;
+      continue;
+    }
+    if (!measured) {
+      s.loadPct[c] = kLoadUnknown;
+      continue;
+    }
+    const uint64_t idle = hal::cpuIdleUs(c);
+    const uint64_t idleUs = std::min<uint64_t>(idle - lastIdleUs_[c], elapsedUs);
+    lastIdleUs_[c] = idle;
+    s.loadPct[c] = (uint8_t)(100u - (uint32_t)((idleUs * 100u + elapsedUs / 2) / elapsedUs));
+  }
+
+  hal::TaskStackInfo info[kMaxTasks];
+  taskCount_ = hal::taskStacks(info, kMaxTasks);
+  for (size_t i = 0; i < taskCount_; ++i) {
+    memcpy(tasks_[i].name, info[i].name, sizeof(tasks_[i].name));
+    tasks_[i].minFreeBytes = info[i].minFreeBytes;
+  }
+
+  head_ = (head_ + 1) % kHistory;
+  count_ = std::min(count_ + 1, kHistory);
+}
+
+uint8_t Telemetry::fragmentationPct(uint32_t freeBytes, uint32_t largestBlock) {
+  if (freeBytes == 0 || largestBlock >= freeBytes) {
+    return 0;
+  }
+  return (uint8_t)(100u - (uint32_t)(((uint64_t)largestBlock * 100u) / freeBytes));
+}
+
+size_t Telemetry::formatRecord(char* out, size_t len) const {
+  if (out == nullptr || len == 0) {
+    return 0;
+  }
+  out[0] = '\0';
+  if (count_ == 0) {
+    return 0;
+  }
+  const Sample& s = sample(0);
+  int n = snprintf(out, len, "t=%lu heap=%lu,%lu,%lu psram=%lu,%lu,%lu cpu=", (unsigned long)(s.tMs / 1000u), (unsigned long)s.heapFree, (unsigned long)s.heapMin, (unsigned long)s.heapLargest,
+                   (unsigned long)s.psramFree, (unsigned long)s.psramMin, (unsigned long)s.psramLargest);
+  if (s.loadPct[0] == kLoadUnknown && n > 0 && (size_t)n < len) {
+    n += snprintf(out + n, len - (size_t)n, "-");
+  } else if (n > 0 && (size_t)n < len) {
+    n += snprintf(out + n, len - (size_t)n, "%u", (unsigned)s.loadPct[0]);
+  }
+  for (uint8_t c = 1; c < cores_ && s.loadPct[0] != kLoadUnknown && n > 0 && (size_t)n < len; ++c) {
+    n += snprintf(out + n, len - (size_t)n, ",%u", (unsigned)s.loadPct[c]);
+  }
+  for (size_t i = 0; i < taskCount_ && n > 0 && (size_t)n < len; ++i) {
+    n += snprintf(out + n, len - (size_t)n, "%s%s:%lu", (i == 0) ? " stk=" : ",", tasks_[i].name, (unsigned long)tasks_[i].minFreeBytes);
+  }
+  return (n > 0) ? std::min((size_t)n, len - 1) : 0;
+}
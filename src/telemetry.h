@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Periodic resource snapshots for soak runs: heap and PSRAM (free, low-water mark, largest
+// free block), stack headroom of the tightest tasks and per-core CPU load. Keeps a short ring
+// of history for the TELEMETRY page; each sample is also formatted as one compact Serial
+// record so long logs can be grepped/plotted for leaks and stack pressure.
+//
+// poll() runs from loop(); sampling is a handful of allocator queries plus one task-list walk,
+// every kPeriodMs. CPU load comes from per-core idle time (hal::cpuIdleUs) between samples;
+// it reads kLoadUnknown when the build cannot measure idle time.
+class Telemetry {
+ public:
+  static constexpr uint32_t kPeriodMs = 5000;
+  static constexpr size_t kHistory = 72;  // 6 minutes
+  static constexpr size_t kMaxTasks = 6;
+  static constexpr size_t kMaxCores = 2;
+  static constexpr uint8_t kLoadUnknown = 0xFF;
+
+  struct Sample {
+    uint32_t tMs = 0;
+    uint32_t heapFree = 0;
+    uint32_t heapMin = 0;
+    uint32_t heapLargest = 0;
+    uint32_t psramFree = 0;
+    uint32_t psramMin = 0;
+    uint32_t psramLargest = 0;
+    uint8_t loadPct[kMaxCores] = {0, 0};
+  };
+
+  struct TaskStack {
+    char name[16];
+    uint32_t minFreeBytes;
+  };
+
+  void begin(uint32_t nowMs);
+
+  // Samples once the period has elapsed; returns true when a new sample is available.
+  bool poll(uint32_t nowMs);
+
+  size_t size() const { return count_; }
+  // age 0 is the latest sample; valid for age < size().
+  const Sample& sample(size_t age) const { return ring_[(head_ + kHistory - 1 - age) % kHistory]; }
+  size_t taskCount() const { return taskCount_; }
+  const TaskStack& task(size_t i) const { return tasks_[i]; }
+  uint8_t coreCount() const { return cores_; }
+
+  // 0 = the free memory is one block; 100 = shattered.
+  static uint8_t fragmentationPct(uint32_t freeBytes, uint32_t largestBlock);
+
+  // "t=<s> heap=<free>,<min>,<largest> psram=<...> cpu=<c0>,<c1> stk=<task>:<bytes>,..."
+  // (cpu=- when load is unknown).
+  size_t formatRecord(char* out, size_t len) const;
+
+ private:
+  void take(uint32_t nowMs);
+
+  Sample ring_[kHistory];
+  size_t head_ = 0;
+  size_t count_ = 0;
+  TaskStack tasks_[kMaxTasks];
+  size_t taskCount_ = 0;
+  uint8_t cores_ = 1;
+  uint64_t lastIdleUs_[kMaxCores] = {0, 0};
+  uint32_t lastUs_ = 0;
+  uint32_t nextMs_ = 0;
+};
@@ -0,0 +1,140 @@
+#include "vad.h"
+
+#include <algorithm>
+
+namespace {
+
+// Voice band: spectrum bins ~250..2500 Hz (see kCentersHz in main.cpp).
+constexpr size_t kVoiceBandFirst = 1;
+constexpr size_t kVoiceBandLast = 11;
+
+// Floors start no higher than this so speech in the very first frame is not learned as noise.
+constexpr float kPrimeMaxDbfs = -45.0f;
+constexpr float kPrimeMaxBand = 20.0f;
+
+}  // namespace
+
+void VoiceActivityDetector::reset() {
+  primed_ = false;
+  speech_ = false;
+  hang_ = 0;
+}
+
+bool VoiceActivityDetector::update(float rmsDbfs, const uint8_t* bands, size_t bandCount) {
+  float band = 0.0f;
+  const bool haveBands = (bands != nullptr && bandCount > kVoiceBandLast);
+  if (haveBands) {
+    uint32_t sum = 0;
+    for (size_t i = kVoiceBandFirst; i <= kVoiceBandLast; ++i) {
+      sum += bands[i];
+    }
+    band = (float)sum / (float)(kVoiceBandLast - kVoiceBandFirst + 1);
+  }
+
+  if (!primed_) {
+    noiseDb_ = std::min(rmsDbfs, kPrimeMaxDbfs);
+    bandFloor_ = std::min(band, kPrimeMaxBand);
+    primed_ = true;
+  }
+
+  const float margin = speech_ ? kHoldMarginDb : kOnsetMarginDb;
+  const bool loud = rmsDbfs > noiseDb_ + margin;
+  const bool voiced = !haveBands || band > bandFloor_ + kBandMargin;
+  const bool active = loud && voiced;
+
+  if (active) {
+    hang_ = kHangoverFrames;
+    speech_ = true;
+  } else if (hang_ > 0) {
+    --hang_;
+    speech_ = true;
+  } else {
+    speech_ = false;
+  }
+
+  // Floors follow quiet frames quickly and loud frames slowly (slower still during speech).
+  const float up = active ? 0.005f : 0.05f;
+  noiseDb_ += (rmsDbfs - noiseDb_) * ((rmsDbfs < noiseDb_) ? 0.5f : up);
+  bandFloor_ += (band - bandFloor_) * ((band < bandFloor_) ? 0.5f : up);
+  return speech_;
+}
+
+void SilenceTrimmer::configure(uint32_t rateHz, size_t chunkSamples) {
+  chunk_ = (chunkSamples > 0) ? chunkSamples : 1;
+  const size_t preRoll = (size_t)(((uint64_t)rateHz * kPreRollMs) / 1000u);
+  ringSlots_ = std::max<size_t>(1, (preRoll + chunk_ - 1) / chunk_);
+  maxGap_ = (size_t)(((uint64_t)rateHz * kMaxGapMs) / 1000u);
+  tail_ = (size_t)(((uint64_t)rateHz * kTailMs) / 1000u);
+  reset();
+}
+
+void SilenceTrimmer::reset() {
+  originalSamples_ = 0;
+  ringSlot_ = 0;
+  ringFilled_ = 0;
+  silentRun_ = 0;
+  lastSpeechEnd_ = 0;
+  seenSpeech_ = false;
+}
+
+size_t SilenceTrimmer::orderRing(int16_t* buf, size_t lastSlot) {
+  std::rotate(buf, buf + (lastSlot + 1) * chunk_, buf + ringSlots_ * chunk_);
+  return ringSlots_ * chunk_;
+}
+
+size_t SilenceTrimmer::commit(int16_t* buf, size_t writePos, size_t n, bool speech, bool* rewritten) {
+  *rewritten = false;
+  originalSamples_ += n;
+  const size_t end = writePos + n;
+
+  if (!seenSpeech_) {
+    const bool wrapped = (ringFilled_ == ringSlots_);
+    if (speech) {
+      seenSpeech_ = true;
+      silentRun_ = 0;
+      if (wrapped) {
+        *rewritten = true;
+        lastSpeechEnd_ = orderRing(buf, ringSlot_);
+      } else {
+        lastSpeechEnd_ = end;
+      }
+      return lastSpeechEnd_;
+    }
+
+    // Leading silence: keep only the most recent pre-roll chunks.
+    ringFilled_ = std::min(ringSlots_, ringFilled_ + 1);
+    ringSlot_ = (ringSlot_ + 1) % ringSlots_;
+    if (ringFilled_ == ringSlots_) {
+      *rewritten = true;
+      return ringSlot_ * chunk_;
+    }
+    return end;
+  }
+
+  if (speech) {
+    silentRun_ = 0;
+    lastSpeechEnd_ = end;
+    return end;
+  }
+
+  silentRun_ += n;
+  return (silentRun_ > maxGap_) ? writePos : end;
+}
+
+size_t SilenceTrimmer::finish(int16_t* buf, size_t writePos, bool* rewritten) {
+  *rewritten = false;
+  if (!seenSpeech_) {
+    if (ringFilled_ == ringSlots_) {
+      *rewritten = true;
+      return orderRing(buf, (ringSlot_ + ringSlots_ - 1) % ringSlots_);
+    }
+    return writePos;
+  }
+
+  const size_t end = lastSpeechEnd_ + tail_;
+  if (end < writePos) {
+    *rewritten = true;
+    return end;
+  }
+  return writePos;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Frame-based voice activity detector driven by the per-chunk metrics the firmware already
+// computes: RMS level (dBFS) and the 16-band spectrum (0..100 per band).
+//
+// A frame is speech when its RMS exceeds a tracked noise floor by a margin (with
+// hysteresis) and the voice band (~250..2500 Hz) rises above its own floor. Decisions are
+// held for a short hangover so word gaps are not cut. Cost is O(band count) per frame.
+class VoiceActivityDetector {
+ public:
+  static constexpr float kOnsetMarginDb = 9.0f;
+  static constexpr float kHoldMarginDb = 5.0f;
+  static constexpr float kBandMargin = 6.0f;  // spectrum units (~0.6 dB each)
+  static constexpr uint8_t kHangoverFrames = 6;
+
+  void reset();
+  bool update(float rmsDbfs, const uint8_t* bands, size_t bandCount);
+
+  bool isSpeech() const { return speech_; }
+  float noiseFloorDbfs() const { return noiseDb_; }
+
+ private:
+  float noiseDb_ = 0.0f;
+  float bandFloor_ = 0.0f;
+  bool primed_ = false;
+  bool speech_ = false;
+  uint8_t hang_ = 0;
+};
+
+// Drops leading, trailing and long inner silences from the capture buffer on the fly.
+//
+// Leading silence is captured into a small ring of pre-roll chunks at the start of the
+// buffer; when speech starts the ring is rotated once into order (O(pre-roll)). Inner
+// silences longer than kMaxGapMs stop advancing the write position, so the next chunk
+// overwrites the dropped one. finish() cuts the trailing silence after the last speech.
+class SilenceTrimmer {
+ public:
+  static constexpr uint32_t kPreRollMs = 200;
+  static constexpr uint32_t kMaxGapMs = 400;
+  static constexpr uint32_t kTailMs = 300;
+
+  void configure(uint32_t rateHz, size_t chunkSamples);
+  void reset();
+
+  // Called after `n` samples were captured at buf[writePos]. Returns the next write
+  // position. *rewritten is set when samples before writePos moved (overview must be
+  // rebuilt); otherwise [writePos, return) is newly kept audio.
+  size_t commit(int16_t* buf, size_t writePos, size_t n, bool speech, bool* rewritten);
+
+  // Finalizes the take; returns the trimmed length.
+  size_t finish(int16_t* buf, size_t writePos, bool* rewritten);
+
+  size_t originalSamples() const { return originalSamples_; }
+
+ private:
+  size_t orderRing(int16_t* buf, size_t lastSlot);
+
+  size_t chunk_ = 512;
+  size_t ringSlots_ = 1;
+  size_t maxGap_ = 0;
+  size_t tail_ = 0;
+
+  size_t originalSamples_ = 0;
+  size_t ringSlot_ = 0;
+  size_t ringFilled_ = 0;
+  size_t silentRun_ = 0;
+  size_t lastSpeechEnd_ = 0;
+  bool seenSpeech_ = false;
+};
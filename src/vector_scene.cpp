@@ -0,0 +1,275 @@
+#include "vector_scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+// 1 / sqrt(bucket midpoint) in Q15 for mantissas in [i/16, (i+1)/16), i = 4..15.
+constexpr uint16_t kRsqrtSeed[12] = {61788, 55889, 51411, 47861, 44957, 42525, 40450, 38651, 37073, 35673, 34421, 33292};
+
+// Screen offset per unit along X, Y and Z in Q14. X: right, Y: up, Z: down-right.
+struct ScreenBasis {
+  int16_t x[3];
+  int16_t y[3];
+};
+constexpr int16_t q14(float v) { return (int16_t)(v * 16384.0f + ((v >= 0.0f) ? 0.5f : -0.5f)); }
+constexpr ScreenBasis kAxesBasis = {{q14(1.0f), q14(0.0f), q14(0.70f)}, {q14(0.0f), q14(-1.0f), q14(0.70f)}};
+
+constexpr int kQ8 = 8 - VectorScene::kSubBits; // sub-pixel -> Q8 pixel shift
+
+inline uint16_t swap16(uint16_t v) { return (uint16_t)((v >> 8) | (v << 8)); }
+
+// Q12 alpha step toward the target for a one-pole low-pass: dt / (tau + dt).
+inline int32_t lowPassQ12(uint32_t dtMs, uint32_t tauMs) {
+  return (int32_t)(((uint64_t)dtMs << 12) / (uint64_t)(tauMs + dtMs));
+}
+
+constexpr int kStateBits = 8; // low-pass state carries 8 extra bits so slow tracks still move
+
+constexpr int32_t kStateOne = 1 << kStateBits;
+
+inline AccelTracks::Vec scaled(const AccelTracks::Vec& v) {
+  return AccelTracks::Vec{v.x * kStateOne, v.y * kStateOne, v.z * kStateOne};
+}
+
+inline AccelTracks::Vec unscaled(const AccelTracks::Vec& v) {
+  const int32_t h = 1 << (kStateBits - 1);
+  return AccelTracks::Vec{(v.x + h) >> kStateBits, (v.y + h) >> kStateBits, (v.z + h) >> kStateBits};
+}
+
+inline void track(AccelTracks::Vec& v, const AccelTracks::Vec& in, int32_t alphaQ12) {
+  v.x += (int32_t)(((int64_t)(in.x * kStateOne - v.x) * alphaQ12) >> 12);
+  v.y += (int32_t)(((int64_t)(in.y * kStateOne - v.y) * alphaQ12) >> 12);
+  v.z += (int32_t)(((int64_t)(in.z * kStateOne - v.z) * alphaQ12) >> 12);
+}
+
+inline bool near(const AccelTracks::Vec& a, const AccelTracks::Vec& b, int32_t tol) {
+  return abs(a.x - b.x) <= tol && abs(a.y - b.y) <= tol && abs(a.z - b.z) <= tol;
+}
+
+}  // namespace
+
+int32_t fastAtan2Cdeg(int32_t y, int32_t x) {
+  if (x == 0 && y == 0) {
+    return 0;
+  }
+  const uint32_t ax = (uint32_t)((x < 0) ? -(int64_t)x : x);
+  const uint32_t ay = (uint32_t)((y < 0) ? -(int64_t)y : y);
+  const bool steep = ay > ax;
+  const int64_t t = (int64_t)((((uint64_t)(steep ? ax : ay)) << 15) / (steep ? ay : ax)); // Q15, 0..1
+  const int64_t inner = 1402 * 32768 + 380 * t;                                              // Q15 cdeg
+  const int64_t sum = 4500 * 32768 + (((32768 - t) * inner) >> 15);
+  int32_t a = (int32_t)((t * sum + (1 << 29)) >> 30);
+  if (steep) {
+    a = 9000 - a;
+  }
+  if (x < 0) {
+    a = 18000 - a;
+  }
+  return (y < 0) ? -a : a;
+}
+
+uint32_t fastRsqrt(uint32_t v) {
+  if (v == 0) {
+    return 0;
+  }
+  // v = m * 2^(32 - shift) with m in [0.25, 1) as Q32 and shift even, so sqrt splits cleanly.
+  const int shift = __builtin_clz(v) & ~1;
+  const uint64_t m = (uint64_t)v << shift;
+  uint64_t y = (uint64_t)kRsqrtSeed[(m >> 28) - 4] << 15; // Q30, 1..2
+  for (int i = 0; i < 2; ++i) {
+    const uint64_t y2 = (y * y) >> 30;          // Q30
+    const uint64_t my2 = (m * y2) >> 32;        // Q30, ~1
+    y = (y * ((3ull << 30) - my2)) >> 31;       // y (3 - m y^2) / 2
+  }
+  // 2^31 / sqrt(v) = y * 2^(shift/2 - 15)
+  const int down = 15 - shift / 2;
+  return (uint32_t)std::min<uint64_t>(0xFFFFFFFFull, (y + ((1ull << down) >> 1)) >> down);
+}
+
+void AccelTracks::update(float ax, float ay, float az, uint32_t nowMs) {
+  raw_.x = (int32_t)lroundf(ax * 4096.0f);
+  raw_.y = (int32_t)lroundf(ay * 4096.0f);
+  raw_.z = (int32_t)lroundf(az * 4096.0f);
+  if (!seeded_) {
+    filtered_ = scaled(raw_);
+    gravity_ = filtered_;
+    seeded_ = true;
+  } else {
+    const uint32_t dt = std::min<uint32_t>(nowMs - lastMs_, kGravityTauMs);
+    track(filtered_, raw_, lowPassQ12(dt, kFilteredTauMs));
+    track(gravity_, raw_, lowPassQ12(dt, kGravityTauMs));
+  }
+  lastMs_ = nowMs;
+}
+
+bool AccelTracks::settling() const {
+  return seeded_ && !(near(filtered(), raw_, kSettledQ12) && near(gravity(), raw_, kSettledQ12));
+}
+
+AccelTracks::Vec AccelTracks::filtered() const {
+  return unscaled(filtered_);
+}
+
+AccelTracks::Vec AccelTracks::gravity() const {
+  return unscaled(gravity_);
+}
+
+void VectorScene::begin(uint16_t* buf, int width, int height, int cx, int cy, int axisLenPx) {
+  buf_ = buf;
+  width_ = width;
+  height_ = height;
+  cx_ = cx;
+  cy_ = cy;
+  axisLen_ = axisLenPx;
+}
+
+VectorScene::Point VectorScene::project(int32_t x, int32_t y, int32_t z) const {
+  // Q12 * Q14 * px -> Q26 px; keep kSubBits of it.
+  const int64_t sx = (int64_t)x * kAxesBasis.x[0] + (int64_t)y * kAxesBasis.x[1] + (int64_t)z * kAxesBasis.x[2];
+  const int64_t sy = (int64_t)x * kAxesBasis.y[0] + (int64_t)y * kAxesBasis.y[1] + (int64_t)z * kAxesBasis.y[2];
+  constexpr int kDown = 26 - kSubBits;
+  constexpr int64_t kHalf = (int64_t)1 << (kDown - 1);
+  Point p;
+  p.x = cx_ * (1 << kSubBits) + (int32_t)((sx * axisLen_ + kHalf) >> kDown);
+  p.y = cy_ * (1 << kSubBits) + (int32_t)((sy * axisLen_ + kHalf) >> kDown);
+  return p;
+}
+
+VectorScene::Point VectorScene::projectClamped(int32_t x, int32_t y, int32_t z, int32_t maxQ12) const {
+  const uint64_t n2 = (uint64_t)((int64_t)x * x + (int64_t)y * y + (int64_t)z * z); // Q24
+  if (maxQ12 > 0 && n2 > (uint64_t)maxQ12 * (uint64_t)maxQ12) {
+    // Scale by max / |v|; |v| >> 4 keeps the Q24 square inside 32 bits up to 16 g.
+    const uint32_t r = fastRsqrt((uint32_t)std::min<uint64_t>(n2 >> 8, 0xFFFFFFFFull)); // 2^31 / (|v| >> 4)
+    const int64_t k = ((int64_t)maxQ12 * r) >> 19;                                      // Q16
+    x = (int32_t)(((int64_t)x * k) >> 16);
+    y = (int32_t)(((int64_t)y * k) >> 16);
+    z = (int32_t)(((int64_t)z * k) >> 16);
+  }
+  return project(x, y, z);
+}
+
+void VectorScene::drawArrow(Point tip, uint16_t color) {
+  drawArrow(origin(), tip, color);
+}
+
+void VectorScene::drawArrow(Point from, Point tip, uint16_t color) {
+  if (buf_ == nullptr) {
+    return;
+  }
+  // Q8 pixels from here on.
+  const int32_t x0 = from.x * (1 << kQ8);
+  const int32_t y0 = from.y * (1 << kQ8);
+  const int32_t x1 = tip.x * (1 << kQ8);
+  const int32_t y1 = tip.y * (1 << kQ8);
+  const int32_t dx = x1 - x0;
+  const int32_t dy = y1 - y0;
+  // len2 = L^2 * 2^8 for a length of L px, so r = 2^27 / L: len2 * r >> 27 is L in Q8 and
+  // d * r >> 21 the unit direction in Q14.
+  const uint32_t len2 = (uint32_t)(((int64_t)dx * dx + (int64_t)dy * dy) >> 8);
+  const uint32_t r = fastRsqrt(len2);
+  const int32_t lenQ8 = (int32_t)(((uint64_t)len2 * r) >> 27);
+  if (lenQ8 < (6 << 8)) {
+    lineAA(x0, y0, x1, y1, color);
+    return;
+  }
+  const int32_t ux = (int32_t)(((int64_t)dx * r) >> 21);
+  const int32_t uy = (int32_t)(((int64_t)dy * r) >> 21);
+  const int32_t bx = x1 - ((ux * kHeadLenPx) >> 6);
+  const int32_t by = y1 - ((uy * kHeadLenPx) >> 6);
+  const int32_t wx = (-uy * kHeadHalfWidthPx) >> 6;
+  const int32_t wy = (ux * kHeadHalfWidthPx) >> 6;
+
+  lineAA(x0, y0, bx, by, color);
+  const int32_t xs[3] = {x1, bx + wx, bx - wx};
+  const int32_t ys[3] = {y1, by + wy, by - wy};
+  triangleAA(xs, ys, color);
+}
+
+void VectorScene::blend(int x, int y, uint16_t color, uint32_t alpha) {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_ || alpha == 0) {
+    return;
+  }
+  uint16_t& px = buf_[(size_t)y * (size_t)width_ + (size_t)x];
+  const uint32_t a5 = (std::min<uint32_t>(alpha, 256) + 4) >> 3; // 0..32
+  if (a5 >= 32) {
+    px = swap16(color);
+    return;
+  }
+  // RGB565 spread as 0x07E0F81F so one multiply blends all three channels.
+  const uint16_t bg = swap16(px);
+  const uint32_t b = (bg | ((uint32_t)bg << 16)) & 0x07E0F81Fu;
+  const uint32_t f = (color | ((uint32_t)color << 16)) & 0x07E0F81Fu;
+  const uint32_t out = ((f * a5 + b * (32 - a5)) >> 5) & 0x07E0F81Fu;
+  px = swap16((uint16_t)(out | (out >> 16)));
+}
+
+// Xiaolin Wu: two pixels per major-axis step, weighted by the fractional minor coordinate.
+// Pixel centers sit on integer coordinates; inputs are Q8.
+void VectorScene::lineAA(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color) {
+  const bool steep = abs(y1 - y0) > abs(x1 - x0);
+  if (steep) {
+    std::swap(x0, y0);
+    std::swap(x1, y1);
+  }
+  if (x0 > x1) {
+    std::swap(x0, x1);
+    std::swap(y0, y1);
+  }
+  const int32_t dx = x1 - x0;
+  const int64_t grad = (dx > 0) ? (int64_t)(y1 - y0) * 65536 / dx : 0; // Q16
+  const int32_t xs = (x0 + 128) >> 8;
+  const int32_t xe = (x1 + 128) >> 8;
+  int64_t yq = (int64_t)y0 * 256 + ((grad * ((int64_t)xs * 256 - x0)) >> 8); // Q16
+  for (int32_t x = xs; x <= xe; ++x, yq += grad) {
+    const int32_t yi = (int32_t)(yq >> 16);
+    const uint32_t f = (uint32_t)((yq >> 8) & 255);
+    if (steep) {
+      blend(yi, x, color, 256 - f);
+      blend(yi + 1, x, color, f);
+    } else {
+      blend(x, yi, color, 256 - f);
+      blend(x, yi + 1, color, f);
+    }
+  }
+}
+
+// Coverage = min over the edges of (signed distance to the edge + 1/2 px), clamped to 0..1.
+void VectorScene::triangleAA(const int32_t* xs, const int32_t* ys, uint16_t color) {
+  int32_t vx[3] = {xs[0], xs[1], xs[2]};
+  int32_t vy[3] = {ys[0], ys[1], ys[2]};
+  const int64_t area = (int64_t)(vx[1] - vx[0]) * (vy[2] - vy[0]) - (int64_t)(vy[1] - vy[0]) * (vx[2] - vx[0]);
+  if (area == 0) {
+    return;
+  }
+  if (area < 0) {
+    std::swap(vx[1], vx[2]);
+    std::swap(vy[1], vy[2]);
+  }
+  // Inward unit normals in Q14 (y grows downward, so inside is to the right of a->b).
+  int32_t nx[3];
+  int32_t ny[3];
+  for (int e = 0; e < 3; ++e) {
+    const int32_t ex = vx[(e + 1) % 3] - vx[e];
+    const int32_t ey = vy[(e + 1) % 3] - vy[e];
+    const uint32_t r = fastRsqrt((uint32_t)(((int64_t)ex * ex + (int64_t)ey * ey) >> 8));
+    nx[e] = (int32_t)(((int64_t)-ey * r) >> 21);
+    ny[e] = (int32_t)(((int64_t)ex * r) >> 21);
+  }
+  const int x0 = std::max(0, (std::min({vx[0], vx[1], vx[2]}) >> 8) - 1);
+  const int x1 = std::min(width_ - 1, (std::max({vx[0], vx[1], vx[2]}) >> 8) + 1);
+  const int y0 = std::max(0, (std::min({vy[0], vy[1], vy[2]}) >> 8) - 1);
+  const int y1 = std::min(height_ - 1, (std::max({vy[0], vy[1], vy[2]}) >> 8) + 1);
+  for (int y = y0; y <= y1; ++y) {
+    for (int x = x0; x <= x1; ++x) {
+      int32_t cover = 256;
+      for (int e = 0; e < 3 && cover > 0; ++e) {
+        const int32_t d = (int32_t)(((int64_t)nx[e] * (x * 256 - vx[e]) + (int64_t)ny[e] * (y * 256 - vy[e])) >> 14); // Q8 px
+        cover = std::min(cover, std::max(0, d + 128));
+      }
+      blend(x, y, color, (uint32_t)cover);
+    }
+  }
+}
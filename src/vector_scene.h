@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Integer helpers for the axes view. Vectors are Q12 g (4096 = 1 g).
+//
+// fastAtan2Cdeg: octant reduction, then atan(t) ~ 45 t + t (1 - t) (14.02 + 3.80 t) degrees
+// on t = min/max in Q15; one integer division per call.
+// fastRsqrt: 2^31 / sqrt(v) from a 12-entry seed table on the normalized mantissa and two
+// Newton steps. The bench build checks both bounds against atan2f / sqrtf.
+static constexpr int32_t kAtan2MaxErrCdeg = 10;   // 0.1 degree
+static constexpr uint32_t kRsqrtMaxErrPpm = 50;
+
+int32_t fastAtan2Cdeg(int32_t y, int32_t x); // centidegrees in (-18000, 18000]; (0, 0) -> 0
+uint32_t fastRsqrt(uint32_t v);              // 2^31 / sqrt(v); 0 -> 0
+
+// Raw, filtered and gravity tracks of the accelerometer in Q12 g. Filtered and gravity are
+// one-pole low-passes with time constants kFilteredTauMs and kGravityTauMs on the actual
+// sample spacing, so the idle poll rate does not change how they look.
+class AccelTracks {
+ public:
+  struct Vec {
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t z = 0;
+  };
+
+  static constexpr uint32_t kFilteredTauMs = 80;
+  static constexpr uint32_t kGravityTauMs = 1000;
+  static constexpr int32_t kSettledQ12 = 123; // 0.03 g per axis, above IMU noise
+
+  // The first sample seeds all three tracks.
+  void update(float ax, float ay, float az, uint32_t nowMs);
+
+  const Vec& raw() const { return raw_; }
+  Vec filtered() const;
+  Vec gravity() const;
+
+  // True while a low-pass is still visibly behind the raw sample (keeps frames coming after
+  // the device stops moving, until the arrows meet).
+  bool settling() const;
+
+ private:
+  Vec raw_;
+  Vec filtered_; // Q20 (extra state bits)
+  Vec gravity_;  // Q20
+  uint32_t lastMs_ = 0;
+  bool seeded_ = false;
+};
+
+// Pseudo-3D arrow renderer that writes anti-aliased pixels straight into a 16-bit LGFX sprite
+// buffer (RGB565, byte-swapped as the sprite stores it). The X/Y/Z screen basis is a constexpr
+// Q14 table; projection, arrow geometry and coverage are integer-only. Shafts are Wu lines and
+// heads are triangles with per-edge distance coverage, both blended over what is already in
+// the buffer. Coordinates are in 1/16 pixel (kSubBits) so slow tilts move smoothly.
+class VectorScene {
+ public:
+  static constexpr int kSubBits = 4;
+  static constexpr int32_t kHeadLenPx = 10;
+  static constexpr int32_t kHeadHalfWidthPx = 6;
+
+  struct Point {
+    int32_t x = 0; // 1/16 px
+    int32_t y = 0;
+  };
+
+  // buf: width x height sprite pixels; (cx, cy) is the scene origin, axisLenPx the length of
+  // a unit (1 g) vector.
+  void begin(uint16_t* buf, int width, int height, int cx, int cy, int axisLenPx);
+
+  // Screen position of a Q12 vector through the X/Y/Z basis; the clamped form first shortens
+  // vectors longer than maxQ12.
+  Point project(int32_t x, int32_t y, int32_t z) const;
+  Point projectClamped(int32_t x, int32_t y, int32_t z, int32_t maxQ12) const;
+  Point origin() const { return Point{cx_ * (1 << kSubBits), cy_ * (1 << kSubBits)}; }
+
+  // Arrow from the origin to tip (tips within 6 px of the origin draw only the shaft).
+  void drawArrow(Point tip, uint16_t color);
+  void drawArrow(Point from, Point tip, uint16_t color);
+
+ private:
+  void blend(int x, int y, uint16_t color, uint32_t alpha);
+  void lineAA(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color);
+  void triangleAA(const int32_t* xs, const int32_t* ys, uint16_t color);
+
+  uint16_t* buf_ = nullptr;
+  int width_ = 0;
+  int height_ = 0;
+  int32_t cx_ = 0;
+  int32_t cy_ = 0;
+  int32_t axisLen_ = 0;
+};
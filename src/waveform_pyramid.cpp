@@ -0,0 +1,155 @@
+#include "waveform_pyramid.h"
+
+namespace {
+
+size_t ceilDiv(size_t a, size_t b) {
+  return (a + b - 1) / b;
+}
+
+WavePeak merge(const WavePeak& a, const WavePeak& b) {
+  WavePeak r;
+  r.lo = (a.lo < b.lo) ? a.lo : b.lo;
+  r.hi = (a.hi > b.hi) ? a.hi : b.hi;
+  return r;
+}
+
+size_t countLevels(size_t baseEntries) {
+  size_t levels = 0;
+  size_t n = baseEntries;
+  while (n > 0 && levels < WaveformPyramid::kMaxLevels) {
+    ++levels;
+    if (n == 1) {
+      break;
+    }
+    n = ceilDiv(n, 2);
+  }
+  return levels;
+}
+
+}  // namespace
+
+size_t WaveformPyramid::bytesFor(size_t maxSamples) {
+  size_t n = ceilDiv(maxSamples, kBaseBlockSamples);
+  const size_t levels = countLevels(n);
+  size_t entries = 0;
+  for (size_t l = 0; l < levels; ++l) {
+    entries += n;
+    n = ceilDiv(n, 2);
+  }
+  return entries * sizeof(WavePeak);
+}
+
+bool WaveformPyramid::init(void* storage, size_t storageBytes, size_t maxSamples) {
+  levelCount_ = 0;
+  maxSamples_ = 0;
+  samples_ = 0;
+  if (storage == nullptr || maxSamples == 0 || storageBytes < bytesFor(maxSamples)) {
+    return false;
+  }
+
+  WavePeak* p = static_cast<WavePeak*>(storage);
+  size_t n = ceilDiv(maxSamples, kBaseBlockSamples);
+  const size_t levels = countLevels(n);
+  for (size_t l = 0; l < levels; ++l) {
+    levels_[l] = p;
+    p += n;
+    n = ceilDiv(n, 2);
+  }
+  levelCount_ = levels;
+  maxSamples_ = maxSamples;
+  return true;
+}
+
+void WaveformPyramid::reset() {
+  samples_ = 0;
+}
+
+void WaveformPyramid::append(const int16_t* pcm, size_t samples) {
+  if (!isReady() || pcm == nullptr || samples == 0) {
+    return;
+  }
+  if (samples > maxSamples_ - samples_) {
+    samples = maxSamples_ - samples_;
+  }
+  if (samples == 0) {
+    return;
+  }
+
+  const size_t firstBlock = samples_ / kBaseBlockSamples;
+  size_t pos = samples_;
+  const size_t end = samples_ + samples;
+  WavePeak* base = levels_[0];
+
+  while (pos < end) {
+    const size_t block = pos / kBaseBlockSamples;
+    const size_t blockEnd = (block + 1) * kBaseBlockSamples;
+    const size_t stop = (blockEnd < end) ? blockEnd : end;
+
+    int lo = 32767;
+    int hi = -32768;
+    for (const int16_t* x = pcm + (pos - samples_); x < pcm + (stop - samples_); ++x) {
+      const int v = *x;
+      if (v < lo) lo = v;
+      if (v > hi) hi = v;
+    }
+
+    WavePeak pk;
+    pk.lo = (int8_t)(lo >> 8);
+    pk.hi = (int8_t)(hi >> 8);
+    // A block that starts here is fresh; otherwise extend the partial block from the last chunk.
+    base[block] = (pos % kBaseBlockSamples == 0) ? pk : merge(base[block], pk);
+    pos = stop;
+  }
+
+  samples_ = end;
+  propagate(firstBlock, (end - 1) / kBaseBlockSamples);
+}
+
+void WaveformPyramid::propagate(size_t firstBlock, size_t lastBlock) {
+  size_t childCount = ceilDiv(samples_, kBaseBlockSamples);
+  for (size_t l = 1; l < levelCount_; ++l) {
+    firstBlock >>= 1;
+    lastBlock >>= 1;
+    const WavePeak* child = levels_[l - 1];
+    WavePeak* cur = levels_[l];
+    for (size_t i = firstBlock; i <= lastBlock; ++i) {
+      const size_t c = i * 2;
+      cur[i] = (c + 1 < childCount) ? merge(child[c], child[c + 1]) : child[c];
+    }
+    childCount = ceilDiv(childCount, 2);
+  }
+}
+
+void WaveformPyramid::rebuild(const int16_t* pcm, size_t samples) {
+  reset();
+  append(pcm, samples);
+}
+
+WavePeak WaveformPyramid::query(size_t begin, size_t end, size_t spanHint) const {
+  WavePeak r;
+  if (!isReady() || samples_ == 0) {
+    return r;
+  }
+  if (end > samples_) {
+    end = samples_;
+  }
+  if (begin >= end) {
+    return r;
+  }
+
+  // Coarsest level whose block still fits in one span.
+  size_t level = 0;
+  while (level + 1 < levelCount_ && (kBaseBlockSamples << (level + 1)) <= spanHint) {
+    ++level;
+  }
+
+  const size_t blockSamples = kBaseBlockSamples << level;
+  const size_t first = begin / blockSamples;
+  const size_t last = (end - 1) / blockSamples;
+  const size_t valid = ceilDiv(samples_, blockSamples);
+  const WavePeak* lv = levels_[level];
+  for (size_t i = first; i <= last && i < valid; ++i) {
+    r = merge(r, lv[i]);
+  }
+  return r;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Min/max envelope of a span of samples, stored as the high byte of int16 PCM.
+struct WavePeak {
+  int8_t lo = 127;
+  int8_t hi = -128;
+
+  bool empty() const { return lo > hi; }
+};
+
+// Multi-resolution min/max overview of a PCM clip, built incrementally as chunks arrive.
+//
+// Level 0 holds one WavePeak per kBaseBlockSamples input samples; every higher level
+// halves the entry count. With 64-sample blocks and 2-byte entries the whole pyramid
+// costs ~3% of the int16 clip size. Rendering a W-column thumbnail picks the level whose
+// blocks are just smaller than one column, so it touches O(W) entries regardless of the
+// clip length.
+class WaveformPyramid {
+ public:
+  static constexpr size_t kBaseBlockSamples = 64;
+  static constexpr size_t kMaxLevels = 20;
+
+  // Storage needed to cover up to maxSamples samples.
+  static size_t bytesFor(size_t maxSamples);
+
+  // Caller owns storage (PSRAM preferred). Returns false if storage is too small.
+  bool init(void* storage, size_t storageBytes, size_t maxSamples);
+
+  bool isReady() const { return levelCount_ > 0; }
+  size_t samples() const { return samples_; }
+  size_t capacitySamples() const { return maxSamples_; }
+
+  void reset();
+
+  // Appends samples to the overview; samples beyond capacity are ignored.
+  void append(const int16_t* pcm, size_t samples);
+
+  // Convenience: reset() + append() over a whole buffer.
+  void rebuild(const int16_t* pcm, size_t samples);
+
+  // Min/max over samples [begin, end), using the coarsest level that still resolves
+  // spans of roughly `spanHint` samples. Touches at most a handful of entries.
+  WavePeak query(size_t begin, size_t end, size_t spanHint) const;
+
+ private:
+  void propagate(size_t firstBlock, size_t lastBlock);
+
+  WavePeak* levels_[kMaxLevels] = {};
+  size_t levelCount_ = 0;
+  size_t maxSamples_ = 0;
+  size_t samples_ = 0;
+};